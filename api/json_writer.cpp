@@ -0,0 +1,136 @@
+// json_writer.cpp — number formatting and the chunked sample body.
+
+#include "json_writer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <memory>
+
+namespace {
+// Longest shortest-roundtrip double ("-2.2250738585072014e-308") and int64
+constexpr std::size_t kMaxNumberChars = 32;
+
+template<typename T>
+void append_chars(std::string& out, T value) {
+    char buf[kMaxNumberChars];
+    const auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, result.ptr);
+}
+} // namespace
+
+void append_json_number(std::string& out, double value) {
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    append_chars(out, value);
+}
+
+void append_json_number(std::string& out, std::int64_t value) {
+    append_chars(out, value);
+}
+
+void append_sample(std::string& out, const Sample& sample) {
+    out += '[';
+    append_json_number(out, sample.ts_ms);
+    out += ',';
+    append_json_number(out, sample.value);
+    out += ']';
+}
+
+void append_sample(std::string& out, const SampleVec& sample) {
+    out += '[';
+    append_json_number(out, sample.ts_ms);
+    out += ",[";
+    for (std::size_t i = 0; i < sample.vals.size(); ++i) {
+        if (i) out += ',';
+        append_json_number(out, sample.vals[i]);
+    }
+    out += "]]";
+}
+
+void append_matrix_sample(std::string& out, const SampleVec& sample, const std::vector<std::size_t>& rows,
+                          const std::vector<std::size_t>& cols, std::size_t width) {
+    out += '[';
+    append_json_number(out, sample.ts_ms);
+    out += ",[";
+    for (std::size_t r = 0; r < rows.size(); ++r) {
+        if (r) out += ',';
+        out += '[';
+        for (std::size_t c = 0; c < cols.size(); ++c) {
+            if (c) out += ',';
+            const std::size_t at = rows[r] * width + cols[c];
+            append_json_number(out, at < sample.vals.size() ? sample.vals[at] : 0.0);
+        }
+        out += ']';
+    }
+    out += "]]";
+}
+
+void append_csv_row(std::string& out, const Sample& sample) {
+    append_chars(out, sample.ts_ms);
+    out += ',';
+    append_chars(out, sample.value);
+    out += '\n';
+}
+
+std::string open_samples_object(const nlohmann::json& meta) {
+    std::string head = meta.dump();
+    head.pop_back();    // '}'
+    if (head.size() > 1) head += ',';
+    head += "\"samples\":[";
+    return head;
+}
+
+void send_encoded(httplib::Response& res,
+                  const char* content_type,
+                  std::string head,
+                  std::size_t count,
+                  std::function<void(std::string&, std::size_t)> encode,
+                  const char* separator,
+                  std::string tail,
+                  bool allow_chunked) {
+    res.status = 200;
+    if (count < kChunkedMinSamples || !allow_chunked) {
+        std::string body = std::move(head);
+        for (std::size_t i = 0; i < count; ++i) {
+            if (i) body += separator;
+            encode(body, i);
+        }
+        body += tail;
+        res.set_content(std::move(body), content_type);
+        return;
+    }
+
+    struct Body {
+        std::string head, tail, buffer;
+        std::size_t count = 0;
+        std::size_t next = 0;
+        std::function<void(std::string&, std::size_t)> encode;
+        const char* separator = "";
+    };
+    auto body = std::make_shared<Body>();
+    body->head = std::move(head);
+    body->tail = std::move(tail);
+    body->count = count;
+    body->encode = std::move(encode);
+    body->separator = separator;
+
+    res.set_chunked_content_provider(content_type, [body](std::size_t, httplib::DataSink& sink) {
+        std::string& out = body->buffer;
+        out.clear();
+        if (body->next == 0) out += body->head;
+
+        const std::size_t end = std::min(body->count, body->next + kSamplesPerChunk);
+        for (; body->next < end; ++body->next) {
+            if (body->next) out += body->separator;
+            body->encode(out, body->next);
+        }
+        if (body->next == body->count) out += body->tail;
+
+        if (!sink.write(out.data(), out.size())) return false;
+        if (body->next == body->count) sink.done();
+        return true;
+    });
+}
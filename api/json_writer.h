@@ -0,0 +1,63 @@
+// json_writer.h — DOM-free encoding of sample ranges for query/export responses.
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_JSON_WRITER_H
+#define SYSTEM_MONITORING_DASHBOARD_JSON_WRITER_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "store/memory_store.h"
+#include "third_party/httplib.h"
+
+// Results with at least this many samples are sent chunked, this many per chunk
+constexpr std::size_t kChunkedMinSamples = 4096;
+constexpr std::size_t kSamplesPerChunk = 2048;
+
+// Shortest text that reads back as the same double (std::to_chars). NaN and
+// infinities become null, as nlohmann::json::dump() writes them.
+void append_json_number(std::string& out, double value);
+
+void append_json_number(std::string& out, std::int64_t value);
+
+// [ts,value]
+void append_sample(std::string& out, const Sample& sample);
+
+// [ts,[v0,v1,...]]
+void append_sample(std::string& out, const SampleVec& sample);
+
+// [ts,[[...],...]]: the picked rows/columns of a row-major matrix sample
+// 'width' columns wide (missing cells read as 0)
+void append_matrix_sample(std::string& out, const SampleVec& sample, const std::vector<std::size_t>& rows,
+                          const std::vector<std::size_t>& cols, std::size_t width);
+
+// ts,value\n
+void append_csv_row(std::string& out, const Sample& sample);
+
+// The dump of a metadata object with a trailing  "samples":[  opened, ready
+// for the samples and a closing  ]}
+std::string open_samples_object(const nlohmann::json& meta);
+
+/**
+ * Send  head item0 sep item1 sep ... tail  where encode(out, i) appends item i.
+ * Items are encoded straight into one buffer; from kChunkedMinSamples items
+ * on (unless 'allow_chunked' is false, e.g. for a body that is cached) the
+ * body goes out with chunked transfer encoding, kSamplesPerChunk items per
+ * chunk through a reused buffer, so memory stays near one chunk rather than
+ * the whole payload. 'encode' must keep its data alive (it outlives the
+ * handler when chunked).
+ */
+void send_encoded(httplib::Response& res,
+                  const char* content_type,
+                  std::string head,
+                  std::size_t count,
+                  std::function<void(std::string&, std::size_t)> encode,
+                  const char* separator,
+                  std::string tail,
+                  bool allow_chunked = true);
+
+#endif // SYSTEM_MONITORING_DASHBOARD_JSON_WRITER_H
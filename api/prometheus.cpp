@@ -0,0 +1,186 @@
+// prometheus.cpp — exposition rendering and the per-tick render thread.
+
+#include "prometheus.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#ifdef DASHBOARD_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "json_writer.h"
+#include "metrics/metric_key.h"
+#include "metrics/time.h"
+
+namespace {
+// The tick generation moves on a tick's first commit; its other tasks commit
+// a few ms later, so wait for them before rendering
+constexpr auto kCoalesceWindow = std::chrono::milliseconds(25);
+constexpr auto kStopCheckInterval = std::chrono::milliseconds(1000);
+
+// A series whose newest sample is this many of its own sample intervals old
+// has stopped (container gone, interface removed, collector paused) and is
+// left out. Above the governor's largest period stretch (4x).
+constexpr std::int64_t kStaleIntervals = 5;
+
+bool is_name_char(char c, bool first) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (!first && c >= '0' && c <= '9');
+}
+
+// Names become [a-zA-Z_][a-zA-Z0-9_]*: "cpu.total_pct" -> cpu_total_pct. The
+// ':' metric names also allow is left to recording rules.
+std::string sanitize_name(const std::string& name) {
+    std::string out = name;
+    if (out.empty() || !is_name_char(out[0], true)) out.insert(out.begin(), '_');
+    for (char& c : out) {
+        if (!is_name_char(c, false)) c = '_';
+    }
+    return out;
+}
+
+void append_label(std::string& out, bool& first, const std::string& name, const std::string& value) {
+    out += first ? '{' : ',';
+    first = false;
+    out += name;
+    out += "=\"";
+    for (const char c : value) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '"') out += "\\\"";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    out += '"';
+}
+
+void append_value(std::string& out, double value) {
+    if (std::isnan(value)) out += "NaN";
+    else if (std::isinf(value)) out += value > 0 ? "+Inf" : "-Inf";
+    else append_json_number(out, value);
+}
+
+// One line per value; 'labels' is the series' own label set, still open
+void append_series(std::string& out, const std::string& name, const std::string& labels, const LatestSample& latest) {
+    const auto line = [&](const std::string& extra, double value) {
+        out += name;
+        out += labels;
+        out += extra;
+        if (!labels.empty() || !extra.empty()) out += '}';
+        out += ' ';
+        append_value(out, value);
+        out += '\n';
+    };
+
+    if (!latest.is_vector) return line({}, latest.vals.empty() ? 0.0 : latest.vals[0]);
+
+    const MatrixShape& shape = latest.shape;
+    const std::size_t width = shape.columns.size();
+    for (std::size_t i = 0; i < latest.vals.size(); ++i) {
+        std::string extra;
+        bool first = labels.empty();
+        if (width && i / width < shape.rows.size()) {
+            append_label(extra, first, "row", shape.rows[i / width]);
+            append_label(extra, first, "column", shape.columns[i % width]);
+        } else {
+            append_label(extra, first, "index", std::to_string(i));
+        }
+        line(extra, latest.vals[i]);
+    }
+}
+
+#ifdef DASHBOARD_HAVE_ZLIB
+std::string gzip_compress(const std::string& text) {
+    z_stream zs{};
+    // windowBits 15 + 16 selects the gzip wrapper
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) return {};
+
+    std::string out(deflateBound(&zs, text.size()), '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+    zs.avail_in = static_cast<uInt>(text.size());
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = static_cast<uInt>(out.size());
+    const int status = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return status == Z_STREAM_END ? out : std::string();
+}
+#endif
+} // namespace
+
+PrometheusExporter::PrometheusExporter(const MemoryStore& store)
+        : store_(store), page_(render()), thread_([this] { run(); }) {}
+
+PrometheusExporter::~PrometheusExporter() {
+    stopping_ = true;
+    if (thread_.joinable()) thread_.join();
+}
+
+PrometheusExporter::Page PrometheusExporter::page() const {
+    std::scoped_lock lk(m_);
+    return page_;
+}
+
+void PrometheusExporter::run() {
+    std::uint64_t seen = store_.tick_generation();
+    while (!stopping_) {
+        const std::uint64_t generation = store_.wait_for_tick(seen, kStopCheckInterval);
+        if (generation == seen) continue;
+
+        std::this_thread::sleep_for(kCoalesceWindow);
+        seen = store_.tick_generation();
+        Page next = render();
+        std::scoped_lock lk(m_);
+        page_ = std::move(next);
+    }
+}
+
+PrometheusExporter::Page PrometheusExporter::render() const {
+    std::vector<LatestSample> latest = store_.latest_samples();
+    const std::int64_t now = now_ms();
+    latest.erase(std::remove_if(latest.begin(), latest.end(), [now](const LatestSample& sample) {
+        return sample.interval_ms > 0 && now - sample.ts_ms > kStaleIntervals * sample.interval_ms;
+    }), latest.end());
+
+    // Lines of one metric family must be contiguous: sort by exported name
+    std::vector<std::pair<std::string, const LatestSample*>> order;
+    order.reserve(latest.size());
+    for (const LatestSample& sample : latest) {
+        order.emplace_back(sanitize_name(parse_selector(sample.selector).metric), &sample);
+    }
+    std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first < b.first : a.second->selector < b.second->selector;
+    });
+
+    auto page = std::make_shared<ExpositionPage>();
+    std::string& out = page->text;
+    out.reserve(latest.size() * 64);
+    const std::string* family = nullptr;
+    for (const auto& [name, sample] : order) {
+        if (!family || *family != name) {
+            out += "# TYPE ";
+            out += name;
+            out += " gauge\n";
+            family = &name;
+        }
+
+        // Labels in name order, so every scrape prints a series the same way
+        MetricSelectorParts parts = parse_selector(sample->selector);
+        std::vector<std::pair<std::string, std::string>> labels(parts.labels.begin(), parts.labels.end());
+        std::sort(labels.begin(), labels.end());
+        std::string label_text;
+        bool first = true;
+        for (const auto& [key, value] : labels) append_label(label_text, first, sanitize_name(key), value);
+
+        append_series(out, name, label_text, *sample);
+    }
+
+#ifdef DASHBOARD_HAVE_ZLIB
+    page->gzip = gzip_compress(out);
+#endif
+    page->series = latest.size();
+    page->rendered_ms = now;
+    return page;
+}
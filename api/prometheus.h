@@ -0,0 +1,61 @@
+// prometheus.h — renders the latest samples as a Prometheus text exposition once per tick.
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_PROMETHEUS_H
+#define SYSTEM_MONITORING_DASHBOARD_PROMETHEUS_H
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "store/memory_store.h"
+
+// One rendered exposition; never modified once published
+struct ExpositionPage {
+    std::string text;
+    std::string gzip;                   // empty when built without zlib
+    std::size_t series = 0;
+    std::int64_t rendered_ms = 0;
+};
+
+/**
+ * A thread waits for each MemoryStore tick and renders the newest sample of
+ * every live series into a fresh ExpositionPage (plus a gzip copy), then
+ * swaps it in. A series whose newest sample is several of its own sample
+ * intervals old is left out. A scrape only copies the page pointer, so its
+ * cost does not depend on the number of scrapers or series.
+ *
+ * Selectors map to Prometheus names and labels: "disk.read{dev=sda,host=x}"
+ * becomes disk_read{dev="sda",host="x"}. Vector series get one line per
+ * element with an "index" label, matrix series "row" and "column" labels.
+ */
+class PrometheusExporter {
+public:
+    using Page = std::shared_ptr<const ExpositionPage>;
+
+    explicit PrometheusExporter(const MemoryStore& store);
+    ~PrometheusExporter();
+
+    PrometheusExporter(const PrometheusExporter&) = delete;
+    PrometheusExporter& operator=(const PrometheusExporter&) = delete;
+
+    Page page() const;
+
+private:
+    void run();
+    Page render() const;
+
+    const MemoryStore& store_;
+    std::atomic<bool> stopping_{false};
+
+    mutable std::mutex m_;    // guards page_
+    Page page_;
+
+    std::thread thread_;
+};
+
+#endif // SYSTEM_MONITORING_DASHBOARD_PROMETHEUS_H
@@ -0,0 +1,88 @@
+// response_cache.cpp — generation-stamped slots with single-flight fills.
+
+#include "response_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+ResponseCache::ResponseCache(const MemoryStore& store, std::size_t max_bytes)
+        : store_(store), max_bytes_(std::max<std::size_t>(1, max_bytes)) {}
+
+ResponseCache::Response ResponseCache::get(const std::string& key, const std::function<CachedResponse()>& compute) {
+    // A tick while computing leaves the slot on the old generation, so the
+    // next request recomputes; waiters already queued get the older answer.
+    const std::uint64_t generation = store_.tick_generation();
+
+    std::promise<Response> promise;
+    std::shared_future<Response> response;
+    bool leader = false;
+    {
+        std::scoped_lock lk(m_);
+        auto it = slots_.find(key);
+        if (it != slots_.end() && it->second.generation == generation) {
+            response = it->second.response;
+            const bool ready = response.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+            (ready ? hits_ : coalesced_)++;
+        } else {
+            misses_++;
+            leader = true;
+            response = promise.get_future().share();
+            if (it != slots_.end()) erase(it);
+            slots_.emplace(key, Slot{generation, response});
+        }
+    }
+
+    if (leader) {
+        try {
+            const Response filled = std::make_shared<const CachedResponse>(compute());
+            promise.set_value(filled);
+
+            // Charge the body to the slot it filled, unless a newer one replaced it
+            std::scoped_lock lk(m_);
+            auto it = slots_.find(key);
+            if (it != slots_.end() && it->second.generation == generation && it->second.bytes == 0) {
+                it->second.bytes = key.size() + filled->body.size();
+                bytes_ += it->second.bytes;
+                evict(generation);
+            }
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+            std::scoped_lock lk(m_);
+            auto it = slots_.find(key);
+            if (it != slots_.end() && it->second.generation == generation) erase(it);
+        }
+    }
+    return response.get();
+}
+
+void ResponseCache::erase(std::unordered_map<std::string, Slot>::iterator it) {
+    bytes_ -= it->second.bytes;
+    slots_.erase(it);
+}
+
+void ResponseCache::evict(std::uint64_t generation) {
+    for (auto it = slots_.begin(); bytes_ > max_bytes_ && it != slots_.end();) {
+        auto next = std::next(it);
+        if (it->second.bytes > 0 && it->second.generation != generation) erase(it);
+        it = next;
+    }
+    for (auto it = slots_.begin(); bytes_ > max_bytes_ && it != slots_.end();) {
+        auto next = std::next(it);
+        if (it->second.bytes > 0) erase(it);
+        it = next;
+    }
+}
+
+nlohmann::json ResponseCache::stats() const {
+    std::scoped_lock lk(m_);
+    const std::uint64_t lookups = hits_ + coalesced_ + misses_;
+    return {
+            {"entries", slots_.size()},
+            {"bytes", bytes_},
+            {"hits", hits_},
+            {"coalesced", coalesced_},
+            {"misses", misses_},
+            {"hit_ratio", lookups ? double(hits_ + coalesced_) / double(lookups) : 0.0}
+    };
+}
@@ -0,0 +1,77 @@
+// response_cache.h — shares identical query responses within one store tick.
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_RESPONSE_CACHE_H
+#define SYSTEM_MONITORING_DASHBOARD_RESPONSE_CACHE_H
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "store/memory_store.h"
+#include "third_party/json.hpp"
+
+struct CachedResponse {
+    int status = 200;
+    std::string content_type;
+    std::string body;
+};
+
+/**
+ * Responses keyed by a normalized request and stamped with the store's tick
+ * generation; the next tick makes them stale. Samples a slower task commits
+ * later in the same tick show up with the next one, so a cached body lags
+ * the store by at most one tick (the fast lane's configured period).
+ * Identical requests that arrive while the first is still being computed
+ * wait for it instead of repeating the work (single-flight). Finished bodies count against a byte budget;
+ * stale ones go first when it is exceeded. Results large enough to stream
+ * chunked are meant to bypass the cache. Hit counts are reported by stats().
+ */
+class ResponseCache {
+public:
+    using Response = std::shared_ptr<const CachedResponse>;
+
+    ResponseCache(const MemoryStore& store, std::size_t max_bytes);
+
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    // The response for 'key' at the current tick: cached, awaited from
+    // a concurrent identical request, or computed here. An exception from
+    // 'compute' reaches every waiter and nothing is cached.
+    Response get(const std::string& key, const std::function<CachedResponse()>& compute);
+
+    // {entries, bytes, hits, coalesced, misses, hit_ratio}
+    nlohmann::json stats() const;
+
+private:
+    struct Slot {
+        std::uint64_t generation = 0;
+        std::shared_future<Response> response;
+        std::size_t bytes = 0;      // key + body once filled; 0 while in flight
+    };
+
+    // Caller holds m_. Forget a slot and its bytes.
+    void erase(std::unordered_map<std::string, Slot>::iterator it);
+
+    // Caller holds m_. Drops stale filled slots, then arbitrary filled ones,
+    // until the budget is met.
+    void evict(std::uint64_t generation);
+
+    const MemoryStore& store_;
+    const std::size_t max_bytes_;
+
+    mutable std::mutex m_;    // guards everything below
+    std::unordered_map<std::string, Slot> slots_;
+    std::size_t bytes_ = 0;
+    std::uint64_t hits_ = 0;
+    std::uint64_t coalesced_ = 0;
+    std::uint64_t misses_ = 0;
+};
+
+#endif // SYSTEM_MONITORING_DASHBOARD_RESPONSE_CACHE_H
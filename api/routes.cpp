@@ -4,15 +4,22 @@
 #include "routes.h"
 
 #include "config.h"
+#include "json_writer.h"
 #include "metrics/metric_key.h"
+#include "metrics/time.h"
+#include "prometheus.h"
+#include "response_cache.h"
+#include "store/downsample.h"
 #include "store/memory_store.h"
 #include "third_party/httplib.h"
 #include "third_party/json.hpp"
+#include "wire_format.h"
 
 #include <algorithm>
 #include <chrono>
 #include <cstdlib>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <string>
@@ -29,28 +36,86 @@ struct MetricDesc {
     std::vector<std::string> labels;
 };
 
-struct MetricSelectorParts {
-    std::string metric;
-    std::unordered_map<std::string, std::string> labels;
-};
-
 const std::unordered_map<std::string, MetricDesc> kMetricRegistry = {
         {"cpu.total_pct", {"%", {"host"}}},
         {"cpu.core_pct", {"%", {"host", "core"}}},
+        {"cpu.mode_pct", {"%", {"host"}}},
+        {"cpu.freq_mhz", {"MHz", {"host", "core"}}},
+        {"sensor.temp", {"celsius", {"host", "sensor"}}},
+        {"sched.ctxt", {"switches/sec", {"host"}}},
+        {"sched.intr", {"events/sec", {"host"}}},
+        {"sched.forks", {"forks/sec", {"host"}}},
+        {"sched.procs_running", {"count", {"host"}}},
+        {"sched.procs_blocked", {"count", {"host"}}},
+        {"sched.runq_wait", {"ms/sec", {"host", "core"}}},
         {"mem.used", {"bytes", {"host"}}},
         {"mem.free", {"bytes", {"host"}}},
+        {"mem.buffers", {"bytes", {"host"}}},
+        {"mem.cached", {"bytes", {"host"}}},
+        {"mem.shmem", {"bytes", {"host"}}},
+        {"mem.dirty", {"bytes", {"host"}}},
+        {"mem.writeback", {"bytes", {"host"}}},
+        {"mem.anon", {"bytes", {"host"}}},
+        {"mem.anon_huge", {"bytes", {"host"}}},
+        {"mem.slab", {"bytes", {"host"}}},
+        {"mem.slab_reclaimable", {"bytes", {"host"}}},
+        {"mem.swap_used", {"bytes", {"host"}}},
+        {"mem.swap_cached", {"bytes", {"host"}}},
+        {"mem.hugepages_total", {"bytes", {"host"}}},
+        {"mem.hugepages_used", {"bytes", {"host"}}},
+        {"vmstat.rate", {"events/sec", {"host", "counter"}}},
+        {"psi.some_pct", {"%", {"host", "resource"}}},
+        {"psi.full_pct", {"%", {"host", "resource"}}},
         {"disk.read", {"bytes/sec", {"host", "dev"}}},
         {"disk.write", {"bytes/sec", {"host", "dev"}}},
-        {"net.rx", {"bytes/sec", {"host", "iface"}}},
-        {"net.tx", {"bytes/sec", {"host", "iface"}}},
+        {"cgroup.cpu_pct", {"%", {"host", "cgroup"}}},
+        {"cgroup.cpu_throttled_pct", {"%", {"host", "cgroup"}}},
+        {"cgroup.mem_current", {"bytes", {"host", "cgroup"}}},
+        {"cgroup.mem_anon", {"bytes", {"host", "cgroup"}}},
+        {"cgroup.mem_file", {"bytes", {"host", "cgroup"}}},
+        {"cgroup.io_read", {"bytes/sec", {"host", "cgroup"}}},
+        {"cgroup.io_write", {"bytes/sec", {"host", "cgroup"}}},
+        {"cgroup.psi_some_pct", {"%", {"host", "cgroup", "resource"}}},
+        {"cgroup.psi_full_pct", {"%", {"host", "cgroup", "resource"}}},
+        {"fs.size", {"bytes", {"host", "mount"}}},
+        {"fs.used", {"bytes", {"host", "mount"}}},
+        {"fs.avail", {"bytes", {"host", "mount"}}},
+        {"fs.used_pct", {"%", {"host", "mount"}}},
+        {"fs.inodes_used", {"count", {"host", "mount"}}},
+        {"fs.inodes_free", {"count", {"host", "mount"}}},
+        {"net.rx", {"bytes/sec", {"host", "iface", "netns"}}},
+        {"net.tx", {"bytes/sec", {"host", "iface", "netns"}}},
+        {"self.missed_ticks", {"count", {"host", "task"}}},
+        {"self.deadline_misses", {"count", {"host", "task"}}},
+        {"self.task_duration_ms", {"ms", {"host", "task"}}},
+        {"self.task_duration_hist", {"runs", {"host", "task"}}},
+        {"self.tick_jitter_ms", {"ms", {"host", "task"}}},
+        {"self.lateness_ms", {"ms", {"host", "task"}}},
+        {"self.items", {"count", {"host", "task"}}},
+        {"self.store_appends", {"count", {"host", "task"}}},
+        {"self.store_append_us", {"us", {"host", "task"}}},
+        {"self.cpu_pct", {"%", {"host"}}},
+        {"self.degradation_level", {"level", {"host"}}},
+        {"irq.rate", {"events/sec", {"host", "irq"}}},
+        {"softirq.rate", {"events/sec", {"host", "softirq"}}},
+        {"irq.cpu_rate", {"events/sec", {"host", "irq"}}},
+        {"softirq.cpu_rate", {"events/sec", {"host", "softirq"}}},
 };
 
 const std::unordered_set<std::string> kPermittedLabelUniverse = {
-        "host", "core", "dev", "iface", "pid", "comm"
+        "host", "core", "dev", "iface", "netns", "resource", "cgroup", "mount", "counter", "irq", "softirq", "sensor", "task", "pid", "comm"
 };
 
 const auto kStartedAt = Clock::now();
 
+// /api/stream: how long a worker waits for events before re-checking the
+// connection, and the quiet time after which a keep-alive comment is sent.
+constexpr auto kStreamPollInterval = std::chrono::milliseconds(1000);
+constexpr int64_t kStreamHeartbeatMs = 15000;
+
+// Upper bound on entries in one POST /api/query_batch
+constexpr std::size_t kMaxBatchQueries = 512;
+
 /**
  * Configure permissive CORS headers so that the dashboard UI can query the API
  * directly from any origin.
@@ -58,8 +123,9 @@ const auto kStartedAt = Clock::now();
 void configure_cors(httplib::Server& server) {
     server.set_default_headers({
             {"Access-Control-Allow-Origin", "*"},
-            {"Access-Control-Allow-Methods", "GET, OPTIONS"},
-            {"Access-Control-Allow-Headers", "Content-Type"}
+            {"Access-Control-Allow-Methods", "GET, POST, OPTIONS"},
+            {"Access-Control-Allow-Headers", "Content-Type, If-None-Match"},
+            {"Access-Control-Expose-Headers", "ETag"}
     });
     server.Options(R"(/.*)", [](const httplib::Request&, httplib::Response& res) {
         res.status = 204;
@@ -98,6 +164,23 @@ std::optional<long long> parse_int64(const std::string& candidate) {
     return value;
 }
 
+/**
+ * True when an If-None-Match header names 'etag' (or is "*"). Weak
+ * validators compare equal to their strong form.
+ */
+bool etag_matches(const std::string& if_none_match, const std::string& etag) {
+    std::istringstream candidates(if_none_match);
+    std::string candidate;
+    while (std::getline(candidates, candidate, ',')) {
+        const auto begin = candidate.find_first_not_of(" \t");
+        if (begin == std::string::npos) continue;
+        candidate = candidate.substr(begin, candidate.find_last_not_of(" \t") + 1 - begin);
+        if (candidate.rfind("W/", 0) == 0) candidate.erase(0, 2);
+        if (candidate == "*" || candidate == etag) return true;
+    }
+    return false;
+}
+
 /**
  * Parse `key:value,key2:value2` label filters used by query/export endpoints.
  */
@@ -135,10 +218,17 @@ std::string build_selector(const std::string& metric_name,
         return metric_name;
     }
 
+    // Canonical order: host first, then the other labels alphabetically
+    std::vector<std::pair<std::string, std::string>> ordered(labels.begin(), labels.end());
+    std::sort(ordered.begin(), ordered.end(), [](const auto& lhs, const auto& rhs) {
+        if ((lhs.first == "host") != (rhs.first == "host")) return lhs.first == "host";
+        return lhs.first < rhs.first;
+    });
+
     std::ostringstream selector;
     selector << metric_name << "{";
     bool first = true;
-    for (const auto& [key, value] : labels) {
+    for (const auto& [key, value] : ordered) {
         if (!first) {
             selector << ",";
         }
@@ -204,120 +294,386 @@ const char* infer_unit_for_metric(const std::string& metric_name) {
 }
 
 /**
- * Export samples to CSV, matching the column order expected by the UI.
+ * Summarize the stored series from the store's label index, optionally only
+ * metrics whose name starts with 'prefix'.
  */
-void write_csv_response(httplib::Response& res,
-                        const std::vector<Sample>& samples,
-                        const std::string& filename = "export.csv") {
-    std::ostringstream csv;
-    csv << "timestamp,value\n";
-    for (const auto& sample : samples) {
-        csv << sample.ts_ms << "," << sample.value << "\n";
+json describe_stored_metrics(const MemoryStore& store, const std::string& prefix) {
+    json metrics_array = json::array();
+    for (const MetricLabels& metric : store.stored_metrics(prefix)) {
+        std::string unit;
+        if (metric.name.find("pct") != std::string::npos) {
+            unit = "%";
+        } else if (metric.name.find("bytes") != std::string::npos) {
+            unit = "bytes";
+        } else {
+            unit = "value";
+        }
+
+        metrics_array.push_back({
+                {"name", metric.name},
+                {"kind", series_kind_name(metric.kind)},
+                {"unit", unit},
+                {"series", metric.series},
+                {"labels", metric.labels}
+        });
     }
-    res.status = 200;
-    res.set_content(csv.str(), "text/csv");
-    res.set_header("Content-Disposition", ("attachment; filename=\"" + filename + "\"").c_str());
+
+    return json{{"metrics", metrics_array}};
 }
 
 /**
- * Parse selectors such as `metric{key=value}` from stored series keys.
+ * Resolve a row/column selection such as `0-3,7,total` or `user,steal` against
+ * the labels of a matrix series. Numeric ranges match numeric labels; other
+ * tokens match labels exactly. An empty spec selects everything.
  */
-MetricSelectorParts parse_selector(const std::string& selector) {
-    MetricSelectorParts parts;
-
-    const auto open_brace = selector.find('{');
-    if (open_brace == std::string::npos) {
-        parts.metric = selector;
-        return parts;
+std::vector<std::size_t> select_matrix_indices(const std::string& spec, const std::vector<std::string>& names) {
+    std::vector<std::size_t> picked;
+    if (spec.empty()) {
+        for (std::size_t i = 0; i < names.size(); ++i) picked.push_back(i);
+        return picked;
     }
 
-    parts.metric = selector.substr(0, open_brace);
-    const auto close_brace = selector.find('}', open_brace);
-    if (close_brace == std::string::npos) {
-        return parts;
-    }
-
-    std::string inside = selector.substr(open_brace + 1, close_brace - open_brace - 1);
-    std::istringstream inside_stream(inside);
+    std::vector<bool> take(names.size(), false);
+    std::istringstream spec_stream(spec);
     std::string token;
-    while (std::getline(inside_stream, token, ',')) {
-        const auto equals = token.find('=');
-        if (equals == std::string::npos) {
-            continue;
+    while (std::getline(spec_stream, token, ',')) {
+        const auto dash = token.find('-');
+        const auto lo = parse_int64(dash == std::string::npos ? token : token.substr(0, dash));
+        const auto hi = dash == std::string::npos ? lo : parse_int64(token.substr(dash + 1));
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            if (names[i] == token) {
+                take[i] = true;
+            } else if (lo && hi) {
+                const auto index = parse_int64(names[i]);
+                if (index && *index >= *lo && *index <= *hi) take[i] = true;
+            }
         }
-
-        std::string key = token.substr(0, equals);
-        std::string value = token.substr(equals + 1);
-        parts.labels[key] = value;
     }
-
-    return parts;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        if (take[i]) picked.push_back(i);
+    }
+    return picked;
 }
 
 /**
- * Convert metric selectors stored in MemoryStore into a user-friendly summary.
+ * Convert label map to JSON object for responses.
  */
-json describe_stored_metrics(const MemoryStore& store) {
-    const std::vector<std::string> selectors = store.list_series_keys();
+json labels_to_json(const std::unordered_map<std::string, std::string>& labels) {
+    json labels_json = json::object();
+    for (const auto& [key, value] : labels) {
+        labels_json[key] = value;
+    }
+    return labels_json;
+}
 
-    std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_set<std::string>>> values_by_metric;
-    std::unordered_map<std::string, std::string> metric_kind;
+/**
+ * Default the host label, validate against the registry and build the store
+ * selector. Shared by every endpoint that names a series.
+ */
+bool resolve_selector(const std::string& metric_name,
+                      std::unordered_map<std::string, std::string>& labels,
+                      std::string& selector,
+                      std::string& error_message) {
+    if (!cfg::HOST_LABEL.empty() && labels.find("host") == labels.end()) {
+        labels.emplace("host", cfg::HOST_LABEL);
+    }
+    if (!validate_metric_and_labels(metric_name, labels, error_message)) {
+        return false;
+    }
+    selector = build_selector(metric_name, labels);
+    return true;
+}
 
-    for (const auto& selector : selectors) {
-        MetricSelectorParts parts = parse_selector(selector);
-        if (parts.metric.empty()) {
-            continue;
+/**
+ * Downsampling request from max_points / step / agg. agg defaults to lttb
+ * when only max_points is given and to avg when a step is; with neither the
+ * spec stays kNone and samples come back raw.
+ */
+bool build_downsample_spec(const std::optional<long long>& max_points,
+                           const std::optional<long long>& step,
+                           const std::string& agg,
+                           DownsampleSpec& spec,
+                           std::string& error_message) {
+    if (max_points && *max_points < 1) {
+        error_message = "'max_points' must be a positive integer";
+        return false;
+    }
+    if (step && *step < 1) {
+        error_message = "'step' must be a positive number of milliseconds";
+        return false;
+    }
+    if (!agg.empty() && !parse_downsample_agg(agg, spec.agg)) {
+        error_message = "'agg' must be one of lttb, minmax, avg, min, max, raw";
+        return false;
+    }
+    if (!max_points && !step) {
+        if (spec.agg != DownsampleAgg::kNone) {
+            error_message = "'agg' needs 'max_points' or 'step'";
+            return false;
         }
+        return true;
+    }
+    if (agg.empty()) spec.agg = step ? DownsampleAgg::kAvg : DownsampleAgg::kLttb;
+    spec.max_points = max_points ? static_cast<std::size_t>(*max_points) : 0;
+    spec.step_ms = step.value_or(0);
+    return true;
+}
 
-        metric_kind[parts.metric] = (parts.metric == "cpu.core_pct") ? "vector" : "scalar";
-        auto& label_map = values_by_metric[parts.metric];
-        for (const auto& [label_key, label_value] : parts.labels) {
-            label_map[label_key].insert(label_value);
-        }
+/**
+ * build_downsample_spec() from the ?max_points=&step=&agg= query parameters.
+ */
+bool parse_downsample_params(const httplib::Request& req, DownsampleSpec& spec, std::string& error_message) {
+    std::optional<long long> max_points;
+    std::optional<long long> step;
+    if (req.has_param("max_points") && !(max_points = parse_int64(req.get_param_value("max_points")))) {
+        error_message = "'max_points' must be an integer";
+        return false;
     }
+    if (req.has_param("step") && !(step = parse_int64(req.get_param_value("step")))) {
+        error_message = "'step' must be an integer (ms)";
+        return false;
+    }
+    return build_downsample_spec(max_points, step, req.get_param_value("agg"), spec, error_message);
+}
 
-    json metrics_array = json::array();
-    for (const auto& [metric, labels_map] : values_by_metric) {
-        json label_values = json::object();
-        for (const auto& [label_key, value_set] : labels_map) {
-            std::vector<std::string> values(value_set.begin(), value_set.end());
-            std::sort(values.begin(), values.end());
-            label_values[label_key] = values;
-        }
+json downsample_to_json(const DownsampleInfo& info) {
+    return json{{"agg", downsample_agg_name(info.agg)},
+                {"step_ms", info.step_ms},
+                {"source_points", info.source_points}};
+}
 
-        std::string unit;
-        if (metric.find("pct") != std::string::npos) {
-            unit = "%";
-        } else if (metric.find("bytes") != std::string::npos) {
-            unit = "bytes";
-        } else {
-            unit = "value";
+// Every element of an incident ring as [ts, value] pairs, oldest first
+template<typename T, typename Fn>
+json incident_ring_to_json(const RingBuffer<T>& ring, Fn&& value_of) {
+    json out = json::array();
+    const RingSpans<T> spans = ring.spans(std::numeric_limits<std::int64_t>::min(),
+                                          std::numeric_limits<std::int64_t>::max());
+    for (std::size_t i = 0; i < spans.size(); ++i) out.push_back(json::array({spans[i].ts_ms, value_of(spans[i])}));
+    return out;
+}
+
+// A burst capture's trigger and window; with 'full', its samples as well
+json incident_to_json(const Incident& incident, bool full) {
+    json out{{"id", incident.id},
+             {"trigger", incident.trigger},
+             {"value", incident.value},
+             {"threshold", incident.threshold},
+             {"start_ms", incident.start_ms},
+             {"end_ms", incident.end_ms},
+             {"interval_ms", incident.interval_ms}};
+    if (!full) return out;
+
+    const auto scalar = [](const Sample& s) { return s.value; };
+    json net_rx = json::object();
+    json net_tx = json::object();
+    for (const auto& [iface, ring] : incident.net_rx) net_rx[iface] = incident_ring_to_json(ring, scalar);
+    for (const auto& [iface, ring] : incident.net_tx) net_tx[iface] = incident_ring_to_json(ring, scalar);
+
+    out["series"] = json{
+            {"cpu.total_pct", incident_ring_to_json(incident.cpu_total, scalar)},
+            {"cpu.core_pct", incident_ring_to_json(incident.cpu_cores, [](const SampleVec& s) { return s.vals; })},
+            {"net.rx", std::move(net_rx)},
+            {"net.tx", std::move(net_tx)}};
+    out["processes"] = incident_ring_to_json(incident.processes, [](const IncidentProcesses& p) {
+        json rows = json::array();
+        for (const auto& row : p.rows) rows.push_back(json{{"pid", row.pid}, {"name", row.name}, {"cpu_pct", row.cpu_pct}});
+        return rows;
+    });
+    return out;
+}
+
+/**
+ * Slice matrix samples to the rows/columns picked by `cores` / `modes` specs
+ * (see select_matrix_indices). Returns {rows, columns, samples}.
+ */
+json matrix_samples_to_json(const std::vector<SampleVec>& samples,
+                            const MatrixShape& shape,
+                            const std::string& cores,
+                            const std::string& modes) {
+    const auto rows = select_matrix_indices(cores, shape.rows);
+    const auto cols = select_matrix_indices(modes, shape.columns);
+    const std::size_t width = shape.columns.size();
+
+    json out_samples = json::array();
+    for (const auto& sample : samples) {
+        json matrix = json::array();
+        for (const std::size_t row : rows) {
+            json cells = json::array();
+            for (const std::size_t col : cols) {
+                const std::size_t at = row * width + col;
+                cells.push_back(at < sample.vals.size() ? sample.vals[at] : 0.0);
+            }
+            matrix.push_back(std::move(cells));
         }
+        out_samples.push_back({sample.ts_ms, std::move(matrix)});
+    }
 
-        metrics_array.push_back({
-                {"name", metric},
-                {"kind", metric_kind[metric]},
-                {"unit", unit},
-                {"labels", label_values}
-        });
+    json row_names = json::array();
+    json col_names = json::array();
+    for (const std::size_t row : rows) row_names.push_back(shape.rows[row]);
+    for (const std::size_t col : cols) col_names.push_back(shape.columns[col]);
+    return json{{"rows", row_names}, {"columns", col_names}, {"samples", std::move(out_samples)}};
+}
+
+/**
+ * Send one /api/query result in the negotiated wire format. 'width' is the
+ * number of values per sample; 'text' appends a sample as JSON (streamed
+ * writer), 'dom' returns it as a json value (CBOR / MessagePack) and 'row'
+ * writes its values into the packed value column. 'allow_chunked' as for
+ * send_encoded().
+ */
+template<typename T, typename TextFn, typename DomFn, typename RowFn>
+void send_query_result(httplib::Response& res,
+                       WireFormat format,
+                       json meta,
+                       std::shared_ptr<const std::vector<T>> samples,
+                       std::size_t width,
+                       TextFn text,
+                       DomFn dom,
+                       RowFn row,
+                       bool allow_chunked) {
+    res.set_header("Vary", "Accept");
+    if (format == WireFormat::kJson) {
+        return send_encoded(res, "application/json", open_samples_object(meta), samples->size(),
+                            [samples, text](std::string& out, std::size_t i) { text(out, (*samples)[i]); },
+                            ",", "]}", allow_chunked);
     }
 
-    std::sort(metrics_array.begin(), metrics_array.end(), [](const json& lhs, const json& rhs) {
-        return lhs["name"].get<std::string>() < rhs["name"].get<std::string>();
-    });
+    res.status = 200;
+    if (format == WireFormat::kColumns) {
+        PackedColumns columns;
+        columns.width = static_cast<std::uint32_t>(width);
+        columns.ts_ms.reserve(samples->size());
+        columns.values.assign(samples->size() * width, std::numeric_limits<double>::quiet_NaN());
+        for (std::size_t i = 0; i < samples->size(); ++i) {
+            columns.ts_ms.push_back((*samples)[i].ts_ms);
+            row((*samples)[i], columns.values.data() + i * width);
+        }
+        return res.set_content(encode_columns(meta, columns), wire_content_type(format));
+    }
 
-    return json{{"metrics", metrics_array}};
+    json encoded = json::array();
+    for (const T& sample : *samples) encoded.push_back(dom(sample));
+    meta["samples"] = std::move(encoded);
+    res.set_content(encode_binary_json(format, meta), wire_content_type(format));
 }
 
 /**
- * Convert label map to JSON object for responses.
+ * A validated /api/query request. Its fields are everything the response
+ * depends on, so cache_key() identifies the response within one store
+ * tick. 'from' enters the key as the first sample it selects: every
+ * 'from' after the previous sample and up to that one reads the same samples.
  */
-json labels_to_json(const std::unordered_map<std::string, std::string>& labels) {
-    json labels_json = json::object();
-    for (const auto& [key, value] : labels) {
-        labels_json[key] = value;
+struct QueryRequest {
+    std::string metric;
+    std::unordered_map<std::string, std::string> labels;
+    std::string selector;
+    std::int64_t from_ms = 0;
+    std::int64_t to_ms = 0;
+    DownsampleSpec reduce;
+    WireFormat format = WireFormat::kJson;
+    std::string cores, modes;
+
+    std::string cache_key(const MemoryStore& store) const {
+        const std::optional<std::int64_t> first = store.first_sample_ms(selector, from_ms);
+        std::string key = selector;
+        for (const auto& part : {first ? std::to_string(*first) : "-" + std::to_string(from_ms),
+                                std::to_string(to_ms), std::to_string(int(format)),
+                                std::string(downsample_agg_name(reduce.agg)), std::to_string(reduce.max_points),
+                                std::to_string(reduce.step_ms), cores, modes}) {
+            key += '\n';
+            key += part;
+        }
+        return key;
     }
-    return labels_json;
+};
+
+/**
+ * Read and encode one /api/query result into 'res'. JSON samples are written
+ * straight into the body (chunked when large and 'allow_chunked') instead of
+ * through a json tree; only the metadata is a DOM.
+ */
+void write_query_response(const MemoryStore& store, const QueryRequest& q, httplib::Response& res,
+                          bool allow_chunked) {
+    const bool downsampled = q.reduce.agg != DownsampleAgg::kNone;
+    DownsampleInfo reduced;
+
+    const bool is_vector_metric = store.vec_series_exists(q.selector);
+    const auto read_vector = [&] {
+        return downsampled ? store.query_vector_downsampled(q.selector, q.from_ms, q.to_ms, q.reduce, &reduced)
+                           : store.query_vector(q.selector, q.from_ms, q.to_ms);
+    };
+
+    json meta{{"metric", q.metric},
+              {"unit", infer_unit_for_metric(q.metric)},
+              {"labels", labels_to_json(q.labels)},
+              {"vector", is_vector_metric}};
+    const MatrixShape shape = is_vector_metric ? store.matrix_shape(q.selector) : MatrixShape{};
+    if (!shape.columns.empty()) {
+        // Matrix series: slice rows (?cores=0-3,total) and columns (?modes=user,steal)
+        auto samples = std::make_shared<const std::vector<SampleVec>>(read_vector());
+        const auto rows = select_matrix_indices(q.cores, shape.rows);
+        const auto cols = select_matrix_indices(q.modes, shape.columns);
+        const std::size_t width = shape.columns.size();
+        json row_names = json::array();
+        json col_names = json::array();
+        for (const std::size_t row : rows) row_names.push_back(shape.rows[row]);
+        for (const std::size_t col : cols) col_names.push_back(shape.columns[col]);
+        meta["rows"] = std::move(row_names);
+        meta["columns"] = std::move(col_names);
+        if (downsampled) meta["downsample"] = downsample_to_json(reduced);
+
+        const auto cell = [width](const SampleVec& sample, std::size_t row, std::size_t col) {
+            const std::size_t at = row * width + col;
+            return at < sample.vals.size() ? sample.vals[at] : 0.0;
+        };
+        return send_query_result(
+                res, q.format, std::move(meta), samples, rows.size() * cols.size(),
+                [rows, cols, width](std::string& out, const SampleVec& sample) {
+                    append_matrix_sample(out, sample, rows, cols, width);
+                },
+                [&rows, &cols, &cell](const SampleVec& sample) {
+                    json matrix = json::array();
+                    for (const std::size_t row : rows) {
+                        json cells = json::array();
+                        for (const std::size_t col : cols) cells.push_back(cell(sample, row, col));
+                        matrix.push_back(std::move(cells));
+                    }
+                    return json{sample.ts_ms, std::move(matrix)};
+                },
+                [&rows, &cols, &cell](const SampleVec& sample, double* values) {
+                    for (const std::size_t row : rows) {
+                        for (const std::size_t col : cols) *values++ = cell(sample, row, col);
+                    }
+                },
+                allow_chunked);
+    } else if (is_vector_metric) {
+        auto samples = std::make_shared<const std::vector<SampleVec>>(read_vector());
+        if (downsampled) meta["downsample"] = downsample_to_json(reduced);
+
+        // Rows can differ in length (core count changed); columns pad with NaN
+        std::size_t width = 0;
+        for (const auto& sample : *samples) width = std::max(width, sample.vals.size());
+        return send_query_result(
+                res, q.format, std::move(meta), samples, width,
+                [](std::string& out, const SampleVec& sample) { append_sample(out, sample); },
+                [](const SampleVec& sample) { return json{sample.ts_ms, sample.vals}; },
+                [](const SampleVec& sample, double* values) {
+                    std::copy(sample.vals.begin(), sample.vals.end(), values);
+                },
+                allow_chunked);
+    }
+
+    auto samples = std::make_shared<const std::vector<Sample>>(
+            downsampled ? store.query_downsampled(q.selector, q.from_ms, q.to_ms, q.reduce, &reduced)
+                        : store.query(q.selector, q.from_ms, q.to_ms));
+    if (downsampled) meta["downsample"] = downsample_to_json(reduced);
+    send_query_result(
+            res, q.format, std::move(meta), samples, 1,
+            [](std::string& out, const Sample& sample) { append_sample(out, sample); },
+            [](const Sample& sample) { return json{sample.ts_ms, sample.value}; },
+            [](const Sample& sample, double* values) { *values = sample.value; },
+            allow_chunked);
 }
 } // namespace
 
@@ -326,7 +682,8 @@ json labels_to_json(const std::unordered_map<std::string, std::string>& labels)
 /**
  * Bind all HTTP routes exposed by the monitoring API.
  */
-void bind_routes(httplib::Server& svr, MemoryStore& store) {
+void bind_routes(httplib::Server& svr, MemoryStore& store, StreamHub& stream, ResponseCache& cache,
+                 const PrometheusExporter& exporter) {
     configure_cors(svr);
 
     svr.Get("/api/info", [&store](const httplib::Request& req, httplib::Response& res) {
@@ -342,14 +699,18 @@ void bind_routes(httplib::Server& svr, MemoryStore& store) {
         return write_json_response(res, data);
     });
 
-    svr.Get("/api/status", [&store](const httplib::Request&, httplib::Response& res) {
+    svr.Get("/api/status", [&store, &stream, &cache](const httplib::Request&, httplib::Response& res) {
         const auto uptime_seconds =
                 std::chrono::duration_cast<std::chrono::seconds>(Clock::now() - kStartedAt).count();
 
         json payload{{"status", "ok"},
                      {"uptime_s", uptime_seconds},
-                     {"metrics_collected", 0},
-                     {"store_size_mb", 0}};
+                     {"metrics_collected", store.series_count()},
+                     {"store_size_mb", 0},
+                     {"stream_clients", stream.subscriber_count()},
+                     {"query_cache", cache.stats()}};
+        if (json self = store.get_snapshot("self"); !self.is_null()) payload["self"] = std::move(self);
+        if (json governor = store.get_snapshot("governor"); !governor.is_null()) payload["governor"] = std::move(governor);
         write_json_response(res, payload);
     });
 
@@ -369,11 +730,48 @@ void bind_routes(httplib::Server& svr, MemoryStore& store) {
         write_json_response(res, json{{"metrics", registry_array}});
     });
 
-    svr.Get("/api/stored", [&store](const httplib::Request&, httplib::Response& res) {
-        write_json_response(res, describe_stored_metrics(store));
+    // Prometheus text exposition, rendered once per tick; a scrape copies the
+    // page pointer and writes the (gzipped, when accepted) buffer.
+    svr.Get("/metrics", [&exporter](const httplib::Request& req, httplib::Response& res) {
+        const PrometheusExporter::Page page = exporter.page();
+        const bool gzip = !page->gzip.empty() &&
+                          req.get_header_value("Accept-Encoding").find("gzip") != std::string::npos;
+        const std::string* body = gzip ? &page->gzip : &page->text;
+
+        if (gzip) res.set_header("Content-Encoding", "gzip");
+        res.set_header("Vary", "Accept-Encoding");
+        res.set_content_provider(
+                body->size(), "text/plain; version=0.0.4; charset=utf-8",
+                [page, body](std::size_t offset, std::size_t length, httplib::DataSink& sink) {
+                    return sink.write(body->data() + offset, length);
+                });
     });
 
-    svr.Get("/api/query", [&store](const httplib::Request& req, httplib::Response& res) {
+    svr.Get("/api/stored", [&store](const httplib::Request& req, httplib::Response& res) {
+        write_json_response(res, describe_stored_metrics(store, req.get_param_value("prefix")));
+    });
+
+    // Label lookups from the index: ?metric=disk.read&label=dev lists the
+    // values, adding &value=sda lists the series carrying that value instead.
+    svr.Get("/api/labels", [&store](const httplib::Request& req, httplib::Response& res) {
+        const std::string metric = req.get_param_value("metric");
+        const std::string label = req.get_param_value("label");
+        if (metric.empty() || label.empty()) {
+            return write_error_response(res, 400, "Missing ?metric or ?label");
+        }
+
+        json payload{{"metric", metric}, {"label", label}};
+        if (req.has_param("value")) {
+            const std::string value = req.get_param_value("value");
+            payload["value"] = value;
+            payload["series"] = store.series_with_label(metric, label, value);
+        } else {
+            payload["values"] = store.label_values(metric, label);
+        }
+        write_json_response(res, payload);
+    });
+
+    svr.Get("/api/query", [&store, &cache](const httplib::Request& req, httplib::Response& res) {
         const std::string metric_name = req.get_param_value("metric");
         if (metric_name.empty()) {
             return write_error_response(res, 400, "Missing ?metric");
@@ -383,42 +781,265 @@ void bind_routes(httplib::Server& svr, MemoryStore& store) {
         const auto to_ms = parse_int64(req.get_param_value("to")).value_or(std::numeric_limits<long long>::max());
 
         auto labels = parse_label_filters(req.get_param_value("labels"));
-        if (!cfg::HOST_LABEL.empty() && labels.find("host") == labels.end()) {
-            labels.emplace("host", cfg::HOST_LABEL);
-        }
-
+        std::string selector;
         std::string error_message;
-        if (!validate_metric_and_labels(metric_name, labels, error_message)) {
+        if (!resolve_selector(metric_name, labels, selector, error_message)) {
             return write_error_response(res, 422, error_message);
         }
 
-        const std::string selector = build_selector(metric_name, labels);
-        const bool is_vector_metric = store.vec_series_exists(selector);
+        DownsampleSpec reduce;
+        if (!parse_downsample_params(req, reduce, error_message)) {
+            return write_error_response(res, 400, error_message);
+        }
+        QueryRequest query;
+        query.metric = metric_name;
+        query.labels = std::move(labels);
+        query.selector = std::move(selector);
+        query.reduce = reduce;
+        query.format = negotiate_wire_format(req.get_header_value("Accept"), true);
+        query.cores = req.get_param_value("cores");
+        query.modes = req.get_param_value("modes");
+
+        // Viewers polling "the last N hours" a few ms apart share one key: the
+        // key holds the first sample 'from' selects, and a 'to' at or past the
+        // last commit covers everything stored, so it becomes open-ended.
+        query.from_ms = from_ms;
+        query.to_ms = to_ms >= store.last_commit_ms() ? std::numeric_limits<std::int64_t>::max() : to_ms;
+
+        // Large results stream chunked from the store instead of being
+        // buffered whole for the cache; reduced ones carry at most two
+        // samples per requested point.
+        std::size_t result_samples = store.count_between(query.selector, query.from_ms, query.to_ms);
+        if (query.reduce.agg != DownsampleAgg::kNone && query.reduce.max_points > 0) {
+            result_samples = std::min(result_samples, 2 * query.reduce.max_points);
+        }
+        if (result_samples >= kChunkedMinSamples) {
+            return write_query_response(store, query, res, true);
+        }
+
+        const ResponseCache::Response cached = cache.get(query.cache_key(store), [&store, &query] {
+            httplib::Response scratch;
+            write_query_response(store, query, scratch, false);
+            return CachedResponse{scratch.status, scratch.get_header_value("Content-Type"), std::move(scratch.body)};
+        });
+
+        // Served from the shared body without copying it
+        res.status = cached->status;
+        res.set_header("Vary", "Accept");
+        res.set_content_provider(
+                cached->body.size(), cached->content_type,
+                [cached](std::size_t offset, std::size_t length, httplib::DataSink& sink) {
+                    return sink.write(cached->body.data() + offset, length);
+                });
+    });
+
+    // Body: {"queries": [{"metric": "disk.read", "labels": {"dev": "sda"}, "from": ms, "to": ms}, ...]}
+    // "labels" may also use the GET form "dev:sda"; matrix entries accept "cores" / "modes",
+    // and any entry "max_points" / "step" / "agg" as in /api/query.
+    // Results come back in request order; an invalid entry gets its own error.
+    svr.Post("/api/query_batch", [&store](const httplib::Request& req, httplib::Response& res) {
+        const json body = json::parse(req.body, nullptr, false);
+        if (body.is_discarded() || !body.is_object() || !body.contains("queries") || !body["queries"].is_array()) {
+            return write_error_response(res, 400, "Body must be {\"queries\": [...]}");
+        }
+        const json& entries = body["queries"];
+        if (entries.size() > kMaxBatchQueries) {
+            return write_error_response(res, 400, "At most " + std::to_string(kMaxBatchQueries) + " queries per batch");
+        }
 
-        json samples = json::array();
-        if (is_vector_metric) {
-            for (const auto& sample : store.query_vector(selector, from_ms, to_ms)) {
-                samples.push_back({sample.ts_ms, sample.vals});
+        struct Entry {
+            std::string metric;
+            std::unordered_map<std::string, std::string> labels;
+            std::string cores, modes;
+            bool downsampled = false;
+            std::size_t query = 0;      // index into 'queries'
+            json error;
+        };
+        std::vector<Entry> parsed(entries.size());
+        std::vector<SeriesQuery> queries;
+        queries.reserve(entries.size());
+
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            Entry& entry = parsed[i];
+            std::string selector;
+            std::string error_message;
+            try {
+                const json& item = entries[i];
+                entry.metric = item.value("metric", "");
+                if (const auto labels_it = item.find("labels"); labels_it != item.end()) {
+                    if (labels_it->is_string()) {
+                        entry.labels = parse_label_filters(labels_it->get<std::string>());
+                    } else if (labels_it->is_object()) {
+                        entry.labels = labels_it->get<std::unordered_map<std::string, std::string>>();
+                    }
+                }
+                entry.cores = item.value("cores", "");
+                entry.modes = item.value("modes", "");
+
+                SeriesQuery query;
+                query.from_ms = item.value("from", 0LL);
+                query.to_ms = item.value("to", std::numeric_limits<long long>::max());
+                if (!resolve_selector(entry.metric, entry.labels, selector, error_message)) {
+                    entry.error = {{"code", 422}, {"message", error_message}};
+                    continue;
+                }
+
+                std::optional<long long> max_points;
+                std::optional<long long> step;
+                if (item.contains("max_points")) max_points = item["max_points"].get<long long>();
+                if (item.contains("step")) step = item["step"].get<long long>();
+                if (!build_downsample_spec(max_points, step, item.value("agg", ""), query.downsample,
+                                           error_message)) {
+                    entry.error = {{"code", 400}, {"message", error_message}};
+                    continue;
+                }
+                entry.downsampled = query.downsample.agg != DownsampleAgg::kNone;
+                query.selector = std::move(selector);
+                entry.query = queries.size();
+                queries.push_back(std::move(query));
+            } catch (const json::exception&) {
+                entry.error = {{"code", 400}, {"message", "Malformed query entry"}};
             }
-        } else {
-            for (const auto& sample : store.query(selector, from_ms, to_ms)) {
-                samples.push_back({sample.ts_ms, sample.value});
+        }
+
+        const std::vector<SeriesResult> found = store.query_batch(queries);
+
+        json results = json::array();
+        for (const Entry& entry : parsed) {
+            if (!entry.error.is_null()) {
+                results.push_back({{"error", entry.error}});
+                continue;
             }
+
+            const SeriesResult& result = found[entry.query];
+            json item{{"metric", entry.metric},
+                      {"unit", infer_unit_for_metric(entry.metric)},
+                      {"labels", labels_to_json(entry.labels)},
+                      {"vector", result.is_vector}};
+            if (!result.shape.columns.empty()) {
+                item.update(matrix_samples_to_json(result.vec_samples, result.shape, entry.cores, entry.modes));
+            } else {
+                json samples = json::array();
+                for (const auto& sample : result.vec_samples) samples.push_back({sample.ts_ms, sample.vals});
+                for (const auto& sample : result.samples) samples.push_back({sample.ts_ms, sample.value});
+                item["samples"] = std::move(samples);
+            }
+            if (entry.downsampled) item["downsample"] = downsample_to_json(result.downsample);
+            results.push_back(std::move(item));
+        }
+        const WireFormat format = negotiate_wire_format(req.get_header_value("Accept"), false);
+        const json payload{{"results", std::move(results)}};
+        if (format == WireFormat::kJson) {
+            return write_json_response(res, payload);
+        }
+        res.set_header("Vary", "Accept");
+        res.status = 200;
+        res.set_content(encode_binary_json(format, payload), wire_content_type(format));
+    });
+
+    // Server-Sent Events: ?series=cpu.total_pct&series=disk.read{dev=sda}[&from=ms]
+    svr.Get("/api/stream", [&stream](const httplib::Request& req, httplib::Response& res) {
+        const std::size_t series_count = req.get_param_value_count("series");
+        if (series_count == 0) {
+            return write_error_response(res, 400, "Missing ?series");
         }
 
-        write_json_response(res, json{{"metric", metric_name},
-                                      {"unit", infer_unit_for_metric(metric_name)},
-                                      {"labels", labels_to_json(labels)},
-                                      {"samples", samples},
-                                      {"vector", is_vector_metric}});
+        std::vector<std::string> selectors;
+        for (std::size_t i = 0; i < series_count; ++i) {
+            MetricSelectorParts parts = parse_selector(req.get_param_value("series", i));
+            std::string selector;
+            std::string error_message;
+            if (!resolve_selector(parts.metric, parts.labels, selector, error_message)) {
+                return write_error_response(res, 422, error_message);
+            }
+            selectors.push_back(std::move(selector));
+        }
+
+        // max_points / step / agg reduce the replay; live ticks are sent as sampled
+        DownsampleSpec replay;
+        std::string error_message;
+        if (!parse_downsample_params(req, replay, error_message)) {
+            return write_error_response(res, 400, error_message);
+        }
+
+        const auto from_ms = parse_int64(req.get_param_value("from")).value_or(now_ms());
+        auto subscriber = stream.subscribe(selectors, from_ms - 1, replay);
+        if (!subscriber) {
+            return write_error_response(res, 503, "Too many stream clients");
+        }
+
+        res.set_header("Cache-Control", "no-cache");
+        res.set_header("X-Accel-Buffering", "no");
+        res.set_chunked_content_provider(
+                "text/event-stream",
+                [&stream, subscriber, last_write_ms = mono_ms()](std::size_t, httplib::DataSink& sink) mutable {
+                    std::vector<StreamHub::Event> events;
+                    if (!stream.next_events(*subscriber, events, kStreamPollInterval)) {
+                        return false;
+                    }
+                    for (const auto& event : events) {
+                        if (!sink.write(event->data(), event->size())) return false;
+                    }
+
+                    // Comment line so proxies and dead peers are noticed on quiet streams
+                    const int64_t now = mono_ms();
+                    if (!events.empty()) {
+                        last_write_ms = now;
+                    } else if (now - last_write_ms >= kStreamHeartbeatMs) {
+                        last_write_ms = now;
+                        if (!sink.write(": ping\n\n", 8)) return false;
+                    }
+                    return true;
+                },
+                [&stream, subscriber](bool) { stream.unsubscribe(subscriber); });
     });
 
-    svr.Get("/api/processes", [&store](const httplib::Request&, httplib::Response& res) {
-        json snapshot = store.get_snapshot("processes");
-        if (snapshot.is_null()) {
-            snapshot = json::array();
+    // Versioned process table; the ETag is its generation. If-None-Match with
+    // the current one (or ?since= equal to it) gets 304. Without ?since= the
+    // body is the full row array; with it, {generation, since, added, removed,
+    // changed}, or {generation, rows} once 'since' is no longer held.
+    svr.Get("/api/processes", [&store](const httplib::Request& req, httplib::Response& res) {
+        const auto since = parse_int64(req.get_param_value("since"));
+        const std::uint64_t since_generation = since && *since > 0 ? static_cast<std::uint64_t>(*since) : 0;
+        const TableRead table = store.read_table("processes", since_generation);
+
+        const std::string etag = "\"" + std::to_string(table.generation) + "\"";
+        res.set_header("ETag", etag);
+        res.set_header("Cache-Control", "no-cache");
+        if (etag_matches(req.get_header_value("If-None-Match"), etag) ||
+            (since && table.is_delta && since_generation == table.generation)) {
+            res.status = 304;
+            return;
+        }
+
+        if (!since) {
+            return write_json_response(res, table.rows);
+        }
+        if (!table.is_delta) {
+            return write_json_response(res, json{{"generation", table.generation}, {"rows", table.rows}});
         }
-        write_json_response(res, snapshot);
+        write_json_response(res, json{{"generation", table.generation},
+                                      {"since", since_generation},
+                                      {"added", table.added},
+                                      {"removed", table.removed},
+                                      {"changed", table.changed}});
+    });
+
+    // Burst captures: summaries by default, one full incident with ?id=
+    svr.Get("/api/incidents", [&store](const httplib::Request& req, httplib::Response& res) {
+        const auto incidents = store.incidents();
+
+        if (req.has_param("id")) {
+            const auto id = parse_int64(req.get_param_value("id"));
+            for (const auto& incident : incidents) {
+                if (id && incident->id == *id) return write_json_response(res, incident_to_json(*incident, true));
+            }
+            return write_error_response(res, 404, "No incident with that id");
+        }
+
+        json summaries = json::array();
+        for (const auto& incident : incidents) summaries.push_back(incident_to_json(*incident, false));
+        write_json_response(res, summaries);
     });
 
     svr.Get("/api/export", [&store](const httplib::Request& req, httplib::Response& res) {
@@ -459,25 +1080,34 @@ void bind_routes(httplib::Server& svr, MemoryStore& store) {
         const auto limit_opt = parse_int64(req.get_param_value("limit"));
         const long long limit = (limit_opt && *limit_opt > 0) ? *limit_opt : std::numeric_limits<long long>::max();
 
+        DownsampleSpec reduce;
+        if (!parse_downsample_params(req, reduce, error_message)) {
+            return write_error_response(res, 400, error_message);
+        }
+
         const std::string selector = build_selector(metric_name, labels);
-        std::vector<Sample> rows = store.query(selector, *from_ms, *to_ms);
+        DownsampleInfo reduced;
+        std::vector<Sample> rows = reduce.agg == DownsampleAgg::kNone
+                                   ? store.query(selector, *from_ms, *to_ms)
+                                   : store.query_downsampled(selector, *from_ms, *to_ms, reduce, &reduced);
         if (static_cast<long long>(rows.size()) > limit) {
             rows.erase(rows.begin(), rows.end() - static_cast<size_t>(limit));
         }
 
+        auto samples = std::make_shared<const std::vector<Sample>>(std::move(rows));
         if (format == "csv") {
-            return write_csv_response(res, rows, "export.csv");
-        }
-
-        json samples = json::array();
-        for (const auto& row : rows) {
-            samples.push_back({row.ts_ms, row.value});
+            res.set_header("Content-Disposition", "attachment; filename=\"export.csv\"");
+            return send_encoded(res, "text/csv", "timestamp,value\n", samples->size(),
+                                [samples](std::string& out, std::size_t i) { append_csv_row(out, (*samples)[i]); },
+                                "", "");
         }
 
-        write_json_response(res, json{{"metric", metric_name},
-                                      {"unit", infer_unit_for_metric(metric_name)},
-                                      {"rollup", "raw"},
-                                      {"labels", labels_to_json(labels)},
-                                      {"samples", samples}});
+        const json meta{{"metric", metric_name},
+                        {"unit", infer_unit_for_metric(metric_name)},
+                        {"rollup", downsample_agg_name(reduced.agg)},
+                        {"labels", labels_to_json(labels)}};
+        send_encoded(res, "application/json", open_samples_object(meta), samples->size(),
+                     [samples](std::string& out, std::size_t i) { append_sample(out, (*samples)[i]); },
+                     ",", "]}");
     });
 }
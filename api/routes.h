@@ -5,13 +5,19 @@
 
 #pragma once
 
+#include "prometheus.h"
+#include "response_cache.h"
 #include "store/memory_store.h"
+#include "stream.h"
 #include "third_party/httplib.h"
 
 /**
  * Register all /api/* endpoints onto the provided httplib server using data
- * retrieved from the shared MemoryStore instance.
+ * retrieved from the shared MemoryStore instance; /api/stream subscribers are
+ * served by 'stream', /api/query responses are shared through 'cache' and
+ * /metrics serves the pages 'exporter' renders.
  */
-void bind_routes(httplib::Server& svr, MemoryStore& store);
+void bind_routes(httplib::Server& svr, MemoryStore& store, StreamHub& stream, ResponseCache& cache,
+                 const PrometheusExporter& exporter);
 
 #endif // SYSTEM_MONITORING_DASHBOARD_ROUTES_H
@@ -0,0 +1,224 @@
+// stream.cpp — StreamHub broadcaster and per-subscriber queues.
+
+#include "stream.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <unordered_set>
+#include <utility>
+
+#include "third_party/json.hpp"
+
+namespace {
+using json = nlohmann::json;
+
+// Tasks of one tick commit a few ms apart; wait this long after the first
+// commit so they go out as one round.
+constexpr auto kCoalesceWindow = std::chrono::milliseconds(25);
+constexpr auto kStopCheckInterval = std::chrono::milliseconds(1000);
+
+// A client this many events behind is dropped (it reconnects with a new 'from')
+constexpr std::size_t kMaxQueuedEvents = 4096;
+
+std::string sse_event(const char* name, const json& data) {
+    std::string out = "event: ";
+    out += name;
+    out += "\ndata: ";
+    out += data.dump();
+    out += "\n\n";
+    return out;
+}
+
+// Drop samples stamped after 'upto_ms', raise 'newest_ts' to the newest one
+// kept, then apply 'reduce' (a no-op for kNone).
+template<typename T>
+void prepare_samples(std::vector<T>& samples, std::int64_t upto_ms, const DownsampleSpec& reduce,
+                     std::int64_t& newest_ts) {
+    while (!samples.empty() && samples.back().ts_ms > upto_ms) samples.pop_back();
+    if (samples.empty()) return;
+    newest_ts = std::max(newest_ts, samples.back().ts_ms);
+
+    if (reduce.agg == DownsampleAgg::kNone) return;
+    std::vector<T> reduced;
+    downsample(spans_of(samples), reduce, reduced);
+    samples.swap(reduced);
+}
+} // namespace
+
+struct StreamHub::Subscriber {
+    std::unordered_set<std::string> selectors;
+
+    std::mutex m;    // guards the fields below
+    std::condition_variable cv;
+    std::deque<Event> queue;
+    bool closed = false;
+
+    void push(Event event) {
+        {
+            std::scoped_lock lk(m);
+            if (closed) return;
+            if (queue.size() >= kMaxQueuedEvents) {
+                closed = true;
+                queue.clear();
+            } else {
+                queue.push_back(std::move(event));
+            }
+        }
+        cv.notify_all();
+    }
+
+    // Put 'events' ahead of everything queued so far (the replay of a new
+    // subscriber, built after it already started receiving broadcasts).
+    void prepend(std::vector<Event> events) {
+        {
+            std::scoped_lock lk(m);
+            if (closed) return;
+            if (queue.size() + events.size() > kMaxQueuedEvents) {
+                closed = true;
+                queue.clear();
+            } else {
+                queue.insert(queue.begin(), std::make_move_iterator(events.begin()),
+                             std::make_move_iterator(events.end()));
+            }
+        }
+        cv.notify_all();
+    }
+
+    void close() {
+        {
+            std::scoped_lock lk(m);
+            closed = true;
+        }
+        cv.notify_all();
+    }
+};
+
+StreamHub::StreamHub(MemoryStore& store, std::size_t max_subscribers)
+        : store_(store), max_subscribers_(max_subscribers), thread_([this] { run(); }) {}
+
+StreamHub::~StreamHub() {
+    stopping_ = true;
+    if (thread_.joinable()) thread_.join();
+
+    std::scoped_lock lk(m_);
+    for (const auto& subscriber : subscribers_) subscriber->close();
+}
+
+std::size_t StreamHub::subscriber_count() const {
+    std::scoped_lock lk(m_);
+    return subscribers_.size();
+}
+
+/**
+ * Encode the samples of 'selector' stamped in (after_ms, upto_ms] as one SSE
+ * event, downsampled by 'reduce' (replays only). Returns an empty string when
+ * there are none; 'newest_ts' is raised to the newest raw timestamp read.
+ */
+std::string StreamHub::encode_samples(const std::string& selector, std::int64_t after_ms, std::int64_t upto_ms,
+                                      std::int64_t& newest_ts, const DownsampleSpec& reduce) const {
+    json samples = json::array();
+    const bool is_vector = store_.has_vector(selector);
+    if (is_vector) {
+        std::vector<SampleVec> found = store_.query_vector_since(selector, after_ms);
+        prepare_samples(found, upto_ms, reduce, newest_ts);
+        for (const auto& sample : found) samples.push_back({sample.ts_ms, sample.vals});
+    } else {
+        std::vector<Sample> found = store_.query_since(selector, after_ms);
+        prepare_samples(found, upto_ms, reduce, newest_ts);
+        for (const auto& sample : found) samples.push_back({sample.ts_ms, sample.value});
+    }
+    if (samples.empty()) return {};
+
+    return sse_event("samples", json{{"series", selector}, {"vector", is_vector}, {"samples", std::move(samples)}});
+}
+
+std::shared_ptr<StreamHub::Subscriber> StreamHub::subscribe(const std::vector<std::string>& selectors,
+                                                            std::int64_t after_ms, const DownsampleSpec& replay) {
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->selectors.insert(selectors.begin(), selectors.end());
+
+    // Under the lock only note where the broadcaster stands for each selector
+    // and start receiving its rounds; the replay is read and encoded after.
+    std::vector<std::pair<std::string, std::int64_t>> replay_upto;
+    {
+        std::scoped_lock lk(m_);
+        if (subscribers_.size() >= max_subscribers_) return nullptr;
+
+        const std::int64_t committed = std::max(after_ms, store_.last_commit_ms());
+        for (const std::string& selector : subscriber->selectors) {
+            auto [it, inserted] = tracked_.try_emplace(selector);
+            Tracked& tracked = it->second;
+            if (inserted) tracked.last_ts = committed;  // first subscriber: rounds continue from here
+            tracked.refs++;
+            replay_upto.emplace_back(selector, tracked.last_ts);
+        }
+        subscribers_.push_back(subscriber);
+    }
+
+    // Canonical selectors in request order, so the client can map them back
+    std::vector<Event> events;
+    events.push_back(std::make_shared<const std::string>(sse_event("subscribed", json{{"series", selectors}})));
+
+    // Backfill up to what the broadcaster had sent, so the shared events
+    // queued meanwhile continue exactly where this one stops.
+    for (const auto& [selector, upto] : replay_upto) {
+        std::int64_t newest = after_ms;
+        std::string event = encode_samples(selector, after_ms, upto, newest, replay);
+        if (!event.empty()) events.push_back(std::make_shared<const std::string>(std::move(event)));
+    }
+    subscriber->prepend(std::move(events));
+    return subscriber;
+}
+
+void StreamHub::unsubscribe(const std::shared_ptr<Subscriber>& subscriber) {
+    subscriber->close();
+
+    std::scoped_lock lk(m_);
+    auto it = std::find(subscribers_.begin(), subscribers_.end(), subscriber);
+    if (it == subscribers_.end()) return;
+    subscribers_.erase(it);
+
+    for (const std::string& selector : subscriber->selectors) {
+        auto tracked = tracked_.find(selector);
+        if (tracked != tracked_.end() && --tracked->second.refs == 0) tracked_.erase(tracked);
+    }
+}
+
+bool StreamHub::next_events(Subscriber& subscriber, std::vector<Event>& out, std::chrono::milliseconds timeout) {
+    out.clear();
+    std::unique_lock<std::mutex> lk(subscriber.m);
+    subscriber.cv.wait_for(lk, timeout, [&] { return subscriber.closed || !subscriber.queue.empty(); });
+    if (subscriber.closed || stopping_) return false;
+
+    out.assign(std::make_move_iterator(subscriber.queue.begin()), std::make_move_iterator(subscriber.queue.end()));
+    subscriber.queue.clear();
+    return true;
+}
+
+void StreamHub::run() {
+    std::uint64_t seen = store_.commit_generation();
+    while (!stopping_) {
+        const std::uint64_t generation = store_.wait_for_commit(seen, kStopCheckInterval);
+        if (generation == seen) continue;
+
+        std::this_thread::sleep_for(kCoalesceWindow);
+        seen = store_.commit_generation();
+        broadcast();
+    }
+}
+
+void StreamHub::broadcast() {
+    std::scoped_lock lk(m_);
+    for (auto& [selector, tracked] : tracked_) {
+        std::string encoded = encode_samples(selector, tracked.last_ts, std::numeric_limits<std::int64_t>::max(),
+                                             tracked.last_ts);
+        if (encoded.empty()) continue;
+
+        const Event event = std::make_shared<const std::string>(std::move(encoded));
+        for (const auto& subscriber : subscribers_) {
+            if (subscriber->selectors.count(selector)) subscriber->push(event);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+// stream.h — fans newly committed samples out to /api/stream subscribers.
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_STREAM_H
+#define SYSTEM_MONITORING_DASHBOARD_STREAM_H
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "store/downsample.h"
+#include "store/memory_store.h"
+
+/**
+ * One broadcaster thread waits for MemoryStore commits, reads the samples
+ * each subscribed selector gained since the last round, and encodes them as
+ * one Server-Sent Event per selector. That event string is shared by every
+ * subscriber of the selector, so encoding cost does not grow with viewers.
+ */
+class StreamHub {
+public:
+    using Event = std::shared_ptr<const std::string>;
+    struct Subscriber;
+
+    StreamHub(MemoryStore& store, std::size_t max_subscribers);
+    ~StreamHub();
+
+    StreamHub(const StreamHub&) = delete;
+    StreamHub& operator=(const StreamHub&) = delete;
+
+    /**
+     * Register a client for canonical selectors. Its queue starts with a
+     * "subscribed" event and the samples stamped after 'after_ms' for each
+     * selector (reduced by 'replay', if given), then receives the shared
+     * per-commit events. Returns nullptr when max_subscribers are already
+     * connected.
+     */
+    std::shared_ptr<Subscriber> subscribe(const std::vector<std::string>& selectors, std::int64_t after_ms,
+                                          const DownsampleSpec& replay = {});
+
+    void unsubscribe(const std::shared_ptr<Subscriber>& subscriber);
+
+    /**
+     * Move the subscriber's queued events into 'out', waiting up to 'timeout'
+     * for the first one. Returns false once the hub is stopping or the client
+     * fell too far behind and was dropped.
+     */
+    bool next_events(Subscriber& subscriber, std::vector<Event>& out, std::chrono::milliseconds timeout);
+
+    std::size_t subscriber_count() const;
+
+private:
+    // Selector with at least one subscriber, and the newest sample already sent
+    struct Tracked {
+        std::int64_t last_ts = 0;
+        std::size_t refs = 0;
+    };
+
+    void run();
+    void broadcast();
+    std::string encode_samples(const std::string& selector, std::int64_t after_ms, std::int64_t upto_ms,
+                               std::int64_t& newest_ts, const DownsampleSpec& reduce = {}) const;
+
+    MemoryStore& store_;
+    const std::size_t max_subscribers_;
+    std::atomic<bool> stopping_{false};
+
+    mutable std::mutex m_;    // guards subscribers_ and tracked_
+    std::vector<std::shared_ptr<Subscriber>> subscribers_;
+    std::unordered_map<std::string, Tracked> tracked_;
+
+    std::thread thread_;
+};
+
+#endif // SYSTEM_MONITORING_DASHBOARD_STREAM_H
@@ -0,0 +1,131 @@
+// wire_format.cpp — Accept parsing, CBOR / MessagePack and packed columns.
+
+#include "wire_format.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace {
+constexpr char kColumnsMagic[4] = {'S', 'M', 'D', 'C'};
+constexpr std::uint16_t kColumnsVersion = 1;
+constexpr std::size_t kColumnsHeaderBytes = 24;
+
+std::string trim(const std::string& text) {
+    std::size_t begin = 0, end = text.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(text[begin]))) ++begin;
+    while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) --end;
+    return text.substr(begin, end - begin);
+}
+
+std::string lower(std::string text) {
+    for (char& c : text) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+bool format_for_type(const std::string& type, bool columns_ok, WireFormat& format) {
+    if (type == "application/json" || type == "application/*" || type == "*/*") format = WireFormat::kJson;
+    else if (type == "application/cbor") format = WireFormat::kCbor;
+    else if (type == "application/msgpack" || type == "application/x-msgpack") format = WireFormat::kMsgpack;
+    else if (type == "application/x-dashboard-columns" && columns_ok) format = WireFormat::kColumns;
+    else return false;
+    return true;
+}
+
+void put_u16(std::string& out, std::uint16_t value) {
+    out += static_cast<char>(value & 0xff);
+    out += static_cast<char>(value >> 8);
+}
+
+void put_u32(std::string& out, std::uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) out += static_cast<char>((value >> shift) & 0xff);
+}
+
+// Append a column of 8-byte values little-endian
+template<typename T>
+void put_column(std::string& out, const std::vector<T>& column) {
+    static_assert(sizeof(T) == 8, "columns hold 8-byte values");
+    const std::size_t at = out.size();
+    out.resize(at + column.size() * 8);
+    char* dst = out.data() + at;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (!column.empty()) std::memcpy(dst, column.data(), column.size() * 8);
+#else
+    for (const T& value : column) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, 8);
+        for (int shift = 0; shift < 64; shift += 8) *dst++ = static_cast<char>((bits >> shift) & 0xff);
+    }
+#endif
+}
+} // namespace
+
+WireFormat negotiate_wire_format(const std::string& accept, bool columns_ok) {
+    WireFormat best = WireFormat::kJson;
+    double best_q = 0.0;
+
+    std::istringstream ranges(accept);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        const std::size_t semicolon = range.find(';');
+        const std::string type = lower(trim(range.substr(0, semicolon)));
+
+        double q = 1.0;
+        if (semicolon != std::string::npos) {
+            const std::string params = lower(range.substr(semicolon + 1));
+            const std::size_t q_at = params.find("q=");
+            if (q_at != std::string::npos) q = std::strtod(params.c_str() + q_at + 2, nullptr);
+        }
+
+        WireFormat format;
+        if (q > best_q && format_for_type(type, columns_ok, format)) {
+            best = format;
+            best_q = q;
+        }
+    }
+    return best;
+}
+
+const char* wire_content_type(WireFormat format) {
+    switch (format) {
+        case WireFormat::kCbor: return "application/cbor";
+        case WireFormat::kMsgpack: return "application/msgpack";
+        case WireFormat::kColumns: return "application/x-dashboard-columns";
+        default: return "application/json";
+    }
+}
+
+std::string encode_binary_json(WireFormat format, const nlohmann::json& payload) {
+    std::string out;
+    if (format == WireFormat::kCbor) {
+        nlohmann::json::to_cbor(payload, out);
+    } else if (format == WireFormat::kMsgpack) {
+        nlohmann::json::to_msgpack(payload, out);
+    } else {
+        out = payload.dump();
+    }
+    return out;
+}
+
+std::string encode_columns(const nlohmann::json& meta, const PackedColumns& columns) {
+    const std::string meta_text = meta.dump();
+    const std::size_t meta_end = kColumnsHeaderBytes + meta_text.size();
+    const std::size_t padded = (meta_end + 7) & ~std::size_t(7);
+
+    std::string out;
+    out.reserve(padded + (columns.ts_ms.size() + columns.values.size()) * 8);
+    out.append(kColumnsMagic, sizeof(kColumnsMagic));
+    put_u16(out, kColumnsVersion);
+    put_u16(out, 0);
+    put_u32(out, static_cast<std::uint32_t>(columns.ts_ms.size()));
+    put_u32(out, columns.width);
+    put_u32(out, static_cast<std::uint32_t>(meta_text.size()));
+    put_u32(out, 0);
+    out += meta_text;
+    out.append(padded - meta_end, '\0');
+
+    put_column(out, columns.ts_ms);
+    put_column(out, columns.values);
+    return out;
+}
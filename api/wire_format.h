@@ -0,0 +1,62 @@
+// wire_format.h — Accept-header negotiation and the binary query encodings.
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_WIRE_FORMAT_H
+#define SYSTEM_MONITORING_DASHBOARD_WIRE_FORMAT_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "third_party/json.hpp"
+
+enum class WireFormat {
+    kJson,
+    kCbor,          // application/cbor, same schema as JSON
+    kMsgpack,       // application/msgpack (or application/x-msgpack), same schema as JSON
+    kColumns        // application/x-dashboard-columns, see encode_columns()
+};
+
+/**
+ * Pick the response format from an Accept header: the supported type with
+ * the highest q (earliest on ties). JSON when nothing else is named, for
+ * the any-media-type wildcard, and for kColumns when 'columns_ok' is false.
+ */
+WireFormat negotiate_wire_format(const std::string& accept, bool columns_ok);
+
+const char* wire_content_type(WireFormat format);
+
+// CBOR / MessagePack encoding of a JSON payload
+std::string encode_binary_json(WireFormat format, const nlohmann::json& payload);
+
+// A query result as columns: one timestamp per sample and 'width' values per
+// sample, row-major (width 1 for scalar series).
+struct PackedColumns {
+    std::uint32_t width = 1;
+    std::vector<std::int64_t> ts_ms;
+    std::vector<double> values;
+};
+
+/**
+ * Packed columns, all integers little-endian:
+ *
+ *   0   char[4]  magic "SMDC"
+ *   4   u16      version (1)
+ *   6   u16      reserved (0)
+ *   8   u32      sample count n
+ *   12  u32      width w (values per sample)
+ *   16  u32      metadata length m
+ *   20  u32      reserved (0)
+ *   24  m bytes  metadata, UTF-8 JSON (the /api/query fields except samples)
+ *       zero padding to a multiple of 8
+ *       n x int64    timestamps (ms)
+ *       n*w x f64    values, row-major
+ *
+ * Both columns start 8-byte aligned, so a browser can wrap them in a
+ * BigInt64Array / Float64Array without copying or parsing.
+ */
+std::string encode_columns(const nlohmann::json& meta, const PackedColumns& columns);
+
+#endif // SYSTEM_MONITORING_DASHBOARD_WIRE_FORMAT_H
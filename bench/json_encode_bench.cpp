@@ -0,0 +1,142 @@
+//
+// json_encode_bench.cpp — compares the nlohmann::json tree encoding of a query
+// result with the DOM-free writer in api/json_writer.cpp.
+//
+// Each encoder runs in a forked child so its peak RSS (ru_maxrss from wait4)
+// is its own; the "baseline" child only builds the samples, and its peak is
+// subtracted. Build with -DDASHBOARD_BUILD_BENCH=ON.
+//
+//   ./bench_json_encode [samples=7200] [iterations=200]
+//
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "../api/json_writer.h"
+#include "third_party/json.hpp"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+using json = nlohmann::json;
+
+// A CPU-percentage-like series, one sample per second
+std::vector<Sample> make_samples(int count) {
+    std::vector<Sample> samples;
+    samples.reserve(count);
+    const std::int64_t start_ms = 1760000000000;
+    for (int i = 0; i < count; ++i) {
+        samples.push_back({start_ms + i * 1000LL, 50.0 + 40.0 * std::sin(i / 60.0) + (i % 7) / 3.0});
+    }
+    return samples;
+}
+
+const json kMeta{{"metric", "cpu.total_pct"}, {"unit", "%"}, {"labels", {{"host", "bench"}}}, {"vector", false}};
+
+// What /api/query did before: one json node per sample, then dump()
+std::size_t encode_dom(const std::vector<Sample>& samples) {
+    json array = json::array();
+    for (const auto& sample : samples) array.push_back({sample.ts_ms, sample.value});
+    json payload = kMeta;
+    payload["samples"] = std::move(array);
+    return payload.dump().size();
+}
+
+// The whole body into one string
+std::size_t encode_writer(const std::vector<Sample>& samples) {
+    std::string body = open_samples_object(kMeta);
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        if (i) body += ',';
+        append_sample(body, samples[i]);
+    }
+    body += "]}";
+    return body.size();
+}
+
+// As send_encoded() streams it: kSamplesPerChunk samples per reused buffer
+std::size_t encode_chunked(const std::vector<Sample>& samples) {
+    static std::string buffer;
+    std::size_t total = 0;
+    for (std::size_t next = 0; next < samples.size();) {
+        buffer.clear();
+        if (next == 0) buffer += open_samples_object(kMeta);
+        const std::size_t end = std::min(samples.size(), next + kSamplesPerChunk);
+        for (; next < end; ++next) {
+            if (next) buffer += ',';
+            append_sample(buffer, samples[next]);
+        }
+        if (next == samples.size()) buffer += "]}";
+        total += buffer.size();
+    }
+    return total;
+}
+
+struct Result {
+    double us_per_encode = 0.0;
+    std::size_t bytes = 0;
+    long peak_rss_kb = 0;
+};
+
+// Run the encoder in a child; time and size come back through a pipe, peak RSS through wait4
+template<typename Fn>
+bool run_in_child(int samples_count, int iterations, Fn&& encode, Result& result) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+
+    const pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        close(fds[0]);
+        const std::vector<Sample> samples = make_samples(samples_count);
+        Result r;
+        const auto start = Clock::now();
+        for (int i = 0; i < iterations; ++i) r.bytes = encode(samples);
+        r.us_per_encode = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / iterations;
+        const ssize_t written = write(fds[1], &r, sizeof(r));
+        _exit(written == sizeof(r) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    const bool got = read(fds[0], &result, sizeof(result)) == sizeof(result);
+    close(fds[0]);
+
+    int status = 0;
+    rusage usage{};
+    if (wait4(pid, &status, 0, &usage) != pid || !got) return false;
+    result.peak_rss_kb = usage.ru_maxrss;
+    return true;
+}
+
+void print_row(const char* name, const Result& r, long baseline_kb, double reference_us) {
+    const double mb_per_s = r.us_per_encode > 0 ? double(r.bytes) / r.us_per_encode : 0.0;
+    std::printf("  %-10s: %10.1f us/encode  %8.1f MB/s  %9zu bytes  peak +%6ld KB  %6.2fx\n",
+                name, r.us_per_encode, mb_per_s, r.bytes, r.peak_rss_kb - baseline_kb,
+                r.us_per_encode > 0 ? reference_us / r.us_per_encode : 0.0);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const int samples = argc > 1 ? std::atoi(argv[1]) : 7200;
+    const int iterations = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    Result baseline, dom, writer, chunked;
+    if (!run_in_child(samples, 1, [](const std::vector<Sample>& s) { return s.size(); }, baseline) ||
+        !run_in_child(samples, iterations, encode_dom, dom) ||
+        !run_in_child(samples, iterations, encode_writer, writer) ||
+        !run_in_child(samples, iterations, encode_chunked, chunked)) {
+        std::perror("bench child");
+        return 1;
+    }
+
+    std::printf("samples=%d iterations=%d (peak RSS over a %ld KB baseline)\n", samples, iterations,
+                baseline.peak_rss_kb);
+    print_row("json tree", dom, baseline.peak_rss_kb, dom.us_per_encode);
+    print_row("writer", writer, baseline.peak_rss_kb, dom.us_per_encode);
+    print_row("chunked", chunked, baseline.peak_rss_kb, dom.us_per_encode);
+    return 0;
+}
@@ -0,0 +1,83 @@
+//
+// net_backends_bench.cpp — compares /proc/net/dev parsing with the rtnetlink dump.
+//
+// Moves itself into a fresh network namespace, creates N dummy links there
+// (bridges when the dummy module is unavailable), then times both readers.
+// Needs CAP_SYS_ADMIN and CAP_NET_ADMIN; build with -DDASHBOARD_BUILD_BENCH=ON.
+//
+//   ./bench_net_backends [links=5000] [iterations=200]
+//
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sched.h>
+#include <string>
+
+#include "collector/net.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Create links through one `ip -batch` process; returns true when all were added.
+bool create_links(int count, const char* kind) {
+    FILE* ip = popen("ip -batch - 2>/dev/null", "w");
+    if (!ip) return false;
+    for (int i = 0; i < count; ++i) {
+        std::fprintf(ip, "link add bench%d type %s\n", i, kind);
+    }
+    return pclose(ip) == 0;
+}
+
+template<typename Fn>
+double time_per_call_us(int iterations, Fn&& fn) {
+    fn();  // warm up allocations and the netlink socket
+    const auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) fn();
+    const auto elapsed = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    return elapsed / iterations;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const int links = argc > 1 ? std::atoi(argv[1]) : 5000;
+    const int iterations = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    if (unshare(CLONE_NEWNET) != 0) {
+        std::perror("unshare(CLONE_NEWNET)");
+        return 1;
+    }
+
+    const char* kind = "dummy";
+    if (!create_links(1, kind)) {
+        kind = "bridge";
+        if (!create_links(1, kind)) {
+            std::fprintf(stderr, "cannot create dummy or bridge links\n");
+            return 1;
+        }
+    }
+    std::system("ip link del bench0 2>/dev/null");
+    if (!create_links(links, kind)) {
+        std::fprintf(stderr, "failed to create %d %s links\n", links, kind);
+        return 1;
+    }
+
+    NetSnapshot snapshot;
+    LinkTable table;
+    size_t proc_rows = 0, netlink_rows = 0;
+
+    const double proc_us = time_per_call_us(iterations, [&] {
+        read_proc_net_dev(snapshot);
+        proc_rows = snapshot.size();
+    });
+    const double netlink_us = time_per_call_us(iterations, [&] {
+        read_netlink_links(table);
+        netlink_rows = 0;
+        for (const auto& slot : table.slots) netlink_rows += slot.present;
+    });
+
+    std::printf("links=%d kind=%s iterations=%d\n", links, kind, iterations);
+    std::printf("  /proc/net/dev : %10.1f us/read  (%zu interfaces)\n", proc_us, proc_rows);
+    std::printf("  rtnetlink     : %10.1f us/read  (%zu interfaces)\n", netlink_us, netlink_rows);
+    std::printf("  speedup       : %10.2fx\n", netlink_us > 0 ? proc_us / netlink_us : 0.0);
+    return 0;
+}
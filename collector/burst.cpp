@@ -0,0 +1,178 @@
+//
+// burst.cpp — BurstCapture trigger handling and the capture loop.
+//
+// The capture keeps its own CPU / interface / process baselines, so the
+// shared collector state behind the 1 s series is never touched and those
+// series stay exactly as they would be without a burst.
+//
+#include "collector/burst.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "collector/cpu.h"
+#include "collector/deadline.h"
+#include "collector/executor.h"
+#include "collector/governor.h"
+#include "collector/net.h"
+#include "collector/proc.h"
+#include "metrics/time.h"
+
+namespace {
+
+constexpr size_t kBurstProcessRows = 10;
+constexpr double kRxAverageWeight = 0.1;
+constexpr unsigned kRxWarmupObservations = 10;
+
+double busy_pct(const CpuTicks& a, const CpuTicks& b) {
+    const uint64_t d_active = b.active >= a.active ? b.active - a.active : 0;
+    const uint64_t d_total = b.total >= a.total ? b.total - a.total : 0;
+    return d_total == 0 ? 0.0 : 100.0 * double(d_active) / double(d_total);
+}
+
+} // namespace
+
+BurstCapture::BurstCapture(MemoryStore& store, BurstConfig config, SamplerGovernor* governor)
+        : store_(store), config_(config), governor_(governor) {}
+
+void BurstCapture::observe_cpu(double total_pct) {
+    if (total_pct >= config_.cpu_pct) fire({"cpu", total_pct, config_.cpu_pct});
+}
+
+void BurstCapture::observe_net_rx(double total_rx_bytes_per_s) {
+    const double threshold = rx_average_ * config_.net_rx_spike;
+    if (rx_observations_ >= kRxWarmupObservations && total_rx_bytes_per_s >= config_.net_rx_floor &&
+        total_rx_bytes_per_s > threshold) {
+        fire({"net_rx", total_rx_bytes_per_s, threshold});
+    }
+
+    rx_average_ = rx_observations_ == 0
+                  ? total_rx_bytes_per_s
+                  : rx_average_ + kRxAverageWeight * (total_rx_bytes_per_s - rx_average_);
+    ++rx_observations_;
+}
+
+void BurstCapture::observe_psi(const char* resource, double some_pct) {
+    if (some_pct >= config_.psi_some_pct) fire({std::string("psi.") + resource, some_pct, config_.psi_some_pct});
+}
+
+void BurstCapture::fire(Trigger trigger) {
+    if (!config_.enabled) return;
+    if (governor_ && governor_->burst_window_ms(config_.window_ms) <= 0) return;
+
+    std::scoped_lock lk(m_);
+    if (pending_ || capturing_ || mono_ms() < quiet_until_) return;
+    trigger_ = std::move(trigger);
+    pending_ = true;
+    cv_.notify_all();
+}
+
+void BurstCapture::run(std::atomic<bool>& running) {
+    std::unique_lock<std::mutex> lk(m_);
+    while (running.load(std::memory_order_relaxed)) {
+        // Re-check the stop flag every second while idle
+        if (!cv_.wait_for(lk, std::chrono::seconds(1), [this] { return pending_; })) continue;
+
+        const Trigger trigger = trigger_;
+        pending_ = false;
+        capturing_ = true;
+        lk.unlock();
+
+        capture(trigger, running);
+
+        lk.lock();
+        capturing_ = false;
+        quiet_until_ = mono_ms() + config_.cooldown_ms;
+    }
+}
+
+void BurstCapture::capture(const Trigger& trigger, std::atomic<bool>& running) {
+    const int64_t window_ms = governor_ ? governor_->burst_window_ms(config_.window_ms) : config_.window_ms;
+    if (window_ms <= 0) return;
+    const int64_t start_ms = now_ms();
+    const int64_t end_mono = mono_ms() + window_ms;
+    int64_t cpu_mark_us = thread_cpu_us();
+
+    // Every ring holds the whole window, so nothing captured is overwritten
+    const std::size_t ticks = std::size_t(window_ms / std::max<int64_t>(config_.interval_ms, 1)) + 1;
+    auto incident = std::make_shared<Incident>();
+    incident->cpu_total.reset(ticks);
+    incident->cpu_cores.reset(ticks);
+    incident->processes.reset(ticks);
+
+    std::vector<CpuTicks> prev_cpu, cur_cpu;
+    NetSnapshot prev_net, cur_net;
+    LinkTable link_table;
+    procmon::ProcSnapshot prev_proc, cur_proc;
+    bool have_net = false, have_proc = false;
+    int64_t prev_mono = 0;
+
+    DeadlineTimer timer;
+    TickSchedule schedule(config_.interval_ms);
+    for (unsigned tick = 0; running.load(std::memory_order_relaxed); ++tick) {
+        timer.wait_until(schedule.next_deadline());
+        const int64_t mono = mono_ms();
+        if (mono >= end_mono) break;
+        const int64_t ts = now_ms();
+
+        if (read_cpu_ticks(cur_cpu)) {
+            if (!prev_cpu.empty() && prev_cpu.size() == cur_cpu.size()) {
+                incident->cpu_total.append(Sample{ts, busy_pct(prev_cpu[0], cur_cpu[0])});
+                SampleVec cores{ts, {}};
+                cores.vals.reserve(cur_cpu.size() - 1);
+                for (size_t i = 1; i < cur_cpu.size(); ++i) cores.vals.push_back(busy_pct(prev_cpu[i], cur_cpu[i]));
+                incident->cpu_cores.append(cores);
+            }
+            std::swap(prev_cpu, cur_cpu);
+        }
+
+        if (read_interface_counters(cur_net, link_table)) {
+            if (have_net && mono > prev_mono) {
+                const double dt_s = double(mono - prev_mono) / 1000.0;
+                for (const auto& [iface, c] : cur_net) {
+                    auto it = prev_net.find(iface);
+                    if (it == prev_net.end()) continue;
+                    const InterfaceCounters& p = it->second;
+                    auto rx = incident->net_rx.try_emplace(iface, ticks).first;
+                    auto tx = incident->net_tx.try_emplace(iface, ticks).first;
+                    rx->second.append(Sample{ts, c.rx_bytes >= p.rx_bytes ? double(c.rx_bytes - p.rx_bytes) / dt_s : 0.0});
+                    tx->second.append(Sample{ts, c.tx_bytes >= p.tx_bytes ? double(c.tx_bytes - p.tx_bytes) / dt_s : 0.0});
+                }
+            }
+            std::swap(prev_net, cur_net);
+            have_net = true;
+        }
+        prev_mono = mono;
+
+        if (tick % unsigned(config_.process_every > 0 ? config_.process_every : 1) == 0 &&
+            procmon::read_proc_snapshot(cur_proc)) {
+            if (have_proc) {
+                IncidentProcesses top{ts, {}};
+                for (auto& row : procmon::top_by_cpu(prev_proc, cur_proc, kBurstProcessRows)) {
+                    top.rows.push_back(IncidentProcesses::Row{row.pid, std::move(row.name), row.cpu_pct});
+                }
+                incident->processes.append(top);
+            }
+            prev_proc = std::move(cur_proc);
+            have_proc = true;
+        }
+
+        if (governor_) {
+            const int64_t cpu_now_us = thread_cpu_us();
+            governor_->charge(cpu_now_us - cpu_mark_us);
+            cpu_mark_us = cpu_now_us;
+        }
+        schedule.advance(mono_ms());
+    }
+
+    incident->id = next_id_++;
+    incident->trigger = trigger.reason;
+    incident->value = trigger.value;
+    incident->threshold = trigger.threshold;
+    incident->start_ms = start_ms;
+    incident->end_ms = now_ms();
+    incident->interval_ms = config_.interval_ms;
+    store_.put_incident(std::move(incident), config_.max_incidents);
+}
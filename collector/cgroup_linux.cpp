@@ -0,0 +1,317 @@
+//
+// cgroup_linux.cpp — cgroup v2 resource collector.
+//
+// The hierarchy is walked once at startup (bounded by CgroupLimits). Every
+// tracked directory with room for children below it gets an inotify watch, so
+// container start/stop shows up as IN_CREATE / IN_DELETE events instead of a
+// full rescan each tick. Each tracked cgroup keeps its stat files open and
+// re-reads them with pread(…, 0).
+//
+#include "collector/cgroup.h"
+
+#include <algorithm>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#include "metrics/time.h"
+
+namespace {
+
+enum CgroupFile {
+    kCpuStat = 0, kMemCurrent, kMemStat, kIoStat,
+    kCpuPressure, kMemPressure, kIoPressure,
+    kCgroupFileCount
+};
+
+constexpr const char* kCgroupFileNames[kCgroupFileCount] = {
+        "cpu.stat", "memory.current", "memory.stat", "io.stat",
+        "cpu.pressure", "memory.pressure", "io.pressure"
+};
+
+struct CgroupEntry {
+    int depth = 0;
+    int wd = -1;
+    int fds[kCgroupFileCount];
+
+    // Baselines for rate computation
+    bool have_prev = false;
+    uint64_t prev_time = 0;
+    uint64_t usage_usec = 0, throttled_usec = 0;
+    uint64_t io_rbytes = 0, io_wbytes = 0;
+    PressureTotals psi[kPressureResourceCount];
+    bool have_psi[kPressureResourceCount] = {};
+
+    CgroupEntry() { std::fill(std::begin(fds), std::end(fds), -1); }
+    CgroupEntry(const CgroupEntry&) = delete;
+    CgroupEntry& operator=(const CgroupEntry&) = delete;
+    ~CgroupEntry() {
+        for (int fd : fds) if (fd >= 0) close(fd);
+    }
+};
+
+// pread the whole (small) file into buf; returns bytes read or 0.
+size_t read_at_zero(int fd, char* buf, size_t cap) {
+    if (fd < 0) return 0;
+    const ssize_t n = pread(fd, buf, cap, 0);
+    return n > 0 ? size_t(n) : 0;
+}
+
+uint64_t parse_u64(const char*& p, const char* end) {
+    uint64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + uint64_t(*p++ - '0');
+    return v;
+}
+
+// Value of "key N" in a flat-keyed file (cpu.stat, memory.stat). 0 if absent.
+uint64_t flat_key_value(const char* buf, size_t len, const char* key) {
+    const size_t klen = std::strlen(key);
+    const char* p = buf;
+    const char* end = buf + len;
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+        if (!eol) eol = end;
+        if (size_t(eol - p) > klen && std::memcmp(p, key, klen) == 0 && p[klen] == ' ') {
+            const char* q = p + klen + 1;
+            return parse_u64(q, eol);
+        }
+        p = eol + 1;
+    }
+    return 0;
+}
+
+// Sum rbytes= / wbytes= over every device line of io.stat.
+void io_stat_totals(const char* buf, size_t len, uint64_t& rbytes, uint64_t& wbytes) {
+    rbytes = wbytes = 0;
+    const char* end = buf + len;
+    for (const char* p = buf; p + 7 < end; ++p) {
+        if (p[1] != 'b' || p[6] != '=' || std::memcmp(p + 2, "ytes", 4) != 0) continue;
+        const char* q = p + 7;
+        if (p[0] == 'r') rbytes += parse_u64(q, end);
+        else if (p[0] == 'w') wbytes += parse_u64(q, end);
+    }
+}
+
+class CgroupTracker {
+public:
+    bool collect(const CgroupLimits& limits, std::vector<CgroupStats>& out) {
+        if (root_.empty() && !find_root()) return false;
+
+        if (limits.max_depth != limits_.max_depth || limits.max_cgroups != limits_.max_cgroups) {
+            limits_ = limits;
+            rebuild();
+        }
+        drain_events();
+        if (needs_rescan_) rescan();
+
+        out.clear();
+        out.reserve(entries_.size());
+        for (auto& [path, e] : entries_) {
+            CgroupStats stats;
+            stats.path = path;
+            sample(*e, stats);
+            out.push_back(std::move(stats));
+        }
+        return true;
+    }
+
+private:
+    bool find_root() {
+        for (const char* candidate : {"/sys/fs/cgroup", "/sys/fs/cgroup/unified"}) {
+            if (access((std::string(candidate) + "/cgroup.controllers").c_str(), R_OK) == 0) {
+                root_ = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void rebuild() {
+        entries_.clear();
+        path_by_wd_.clear();
+        if (inotify_fd_ >= 0) close(inotify_fd_);
+        inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        watch("");
+        rescan();
+    }
+
+    // Full walk; only used at startup, on limit changes, and after overflow.
+    void rescan() {
+        needs_rescan_ = false;
+        walk("", 0);
+    }
+
+    void walk(const std::string& rel, int depth) {
+        if (depth >= limits_.max_depth) return;
+
+        DIR* d = opendir(abs_path(rel).c_str());
+        if (!d) return;
+        while (dirent* de = readdir(d)) {
+            if (de->d_type != DT_DIR || de->d_name[0] == '.') continue;
+            const std::string child = rel.empty() ? de->d_name : rel + "/" + de->d_name;
+            if (add(child, depth + 1)) walk(child, depth + 1);
+        }
+        closedir(d);
+    }
+
+    // Start tracking a cgroup; returns true if it is (now) tracked.
+    bool add(const std::string& rel, int depth) {
+        if (entries_.count(rel)) return true;
+        if (entries_.size() >= limits_.max_cgroups) {
+            overflowed_ = true;
+            return false;
+        }
+
+        auto e = std::make_unique<CgroupEntry>();
+        e->depth = depth;
+        const std::string base = abs_path(rel) + "/";
+        for (int f = 0; f < kCgroupFileCount; ++f) {
+            e->fds[f] = open((base + kCgroupFileNames[f]).c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        if (depth < limits_.max_depth) e->wd = watch(rel);
+        entries_.emplace(rel, std::move(e));
+        return true;
+    }
+
+    void remove_subtree(const std::string& rel) {
+        const std::string prefix = rel + "/";
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            if (it->first == rel || it->first.compare(0, prefix.size(), prefix) == 0) {
+                if (it->second->wd >= 0) {
+                    inotify_rm_watch(inotify_fd_, it->second->wd);
+                    path_by_wd_.erase(it->second->wd);
+                }
+                it = entries_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        // Room freed up: pick up cgroups skipped while we were at the limit
+        if (overflowed_) {
+            overflowed_ = false;
+            needs_rescan_ = true;
+        }
+    }
+
+    int watch(const std::string& rel) {
+        if (inotify_fd_ < 0) return -1;
+        const int wd = inotify_add_watch(inotify_fd_, abs_path(rel).c_str(),
+                                         IN_CREATE | IN_DELETE | IN_ONLYDIR);
+        if (wd >= 0) path_by_wd_[wd] = rel;
+        return wd;
+    }
+
+    void drain_events() {
+        if (inotify_fd_ < 0) return;
+        alignas(inotify_event) char buf[4096];
+        while (true) {
+            const ssize_t n = read(inotify_fd_, buf, sizeof(buf));
+            if (n <= 0) break;  // EAGAIN: queue drained
+
+            for (char* p = buf; p < buf + n;) {
+                const auto* ev = reinterpret_cast<const inotify_event*>(p);
+                p += sizeof(inotify_event) + ev->len;
+
+                if (ev->mask & IN_Q_OVERFLOW) {
+                    needs_rescan_ = true;
+                    continue;
+                }
+                if (!(ev->mask & IN_ISDIR) || ev->len == 0) continue;
+
+                auto it = path_by_wd_.find(ev->wd);
+                if (it == path_by_wd_.end()) continue;
+                const std::string& parent = it->second;
+                const std::string child = parent.empty() ? ev->name : parent + "/" + ev->name;
+                const int depth = parent.empty() ? 1 : entries_.count(parent) ? entries_[parent]->depth + 1 : 1;
+
+                if (ev->mask & IN_CREATE) {
+                    if (depth <= limits_.max_depth && add(child, depth)) walk(child, depth);
+                } else if (ev->mask & IN_DELETE) {
+                    remove_subtree(child);
+                }
+            }
+        }
+    }
+
+    void sample(CgroupEntry& e, CgroupStats& stats) {
+        char buf[8192];
+        const uint64_t time_now = tick_mono_ms();
+        const double dt_us = e.have_prev && time_now > e.prev_time ? double(time_now - e.prev_time) * 1000.0 : 0.0;
+
+        if (size_t n = read_at_zero(e.fds[kCpuStat], buf, sizeof(buf))) {
+            const uint64_t usage = flat_key_value(buf, n, "usage_usec");
+            const uint64_t throttled = flat_key_value(buf, n, "throttled_usec");
+            if (dt_us > 0) {
+                stats.cpu_pct = usage >= e.usage_usec ? 100.0 * double(usage - e.usage_usec) / dt_us : 0.0;
+                stats.cpu_throttled_pct = throttled >= e.throttled_usec
+                                          ? 100.0 * double(throttled - e.throttled_usec) / dt_us : 0.0;
+            }
+            e.usage_usec = usage;
+            e.throttled_usec = throttled;
+        }
+
+        if (size_t n = read_at_zero(e.fds[kMemCurrent], buf, sizeof(buf))) {
+            const char* p = buf;
+            stats.mem_current = parse_u64(p, buf + n);
+            stats.has_memory = true;
+        }
+        if (size_t n = read_at_zero(e.fds[kMemStat], buf, sizeof(buf))) {
+            stats.mem_anon = flat_key_value(buf, n, "anon");
+            stats.mem_file = flat_key_value(buf, n, "file");
+        }
+
+        if (e.fds[kIoStat] >= 0) {
+            const size_t n = read_at_zero(e.fds[kIoStat], buf, sizeof(buf));
+            uint64_t rbytes = 0, wbytes = 0;
+            io_stat_totals(buf, n, rbytes, wbytes);
+            if (dt_us > 0) {
+                const double dt_s = dt_us / 1e6;
+                stats.io_read_bytes_per_s = rbytes >= e.io_rbytes ? double(rbytes - e.io_rbytes) / dt_s : 0.0;
+                stats.io_write_bytes_per_s = wbytes >= e.io_wbytes ? double(wbytes - e.io_wbytes) / dt_s : 0.0;
+            }
+            e.io_rbytes = rbytes;
+            e.io_wbytes = wbytes;
+            stats.has_io = true;
+        }
+
+        for (int r = 0; r < kPressureResourceCount; ++r) {
+            const size_t n = read_at_zero(e.fds[kCpuPressure + r], buf, sizeof(buf));
+            PressureTotals cur;
+            if (n == 0 || !parse_pressure_totals(buf, n, cur)) {
+                e.have_psi[r] = false;
+                continue;
+            }
+            stats.pressure[r] = pressure_pct_between(e.psi[r], cur, e.have_psi[r] ? dt_us : 0.0);
+            e.psi[r] = cur;
+            e.have_psi[r] = true;
+        }
+
+        e.prev_time = time_now;
+        e.have_prev = true;
+    }
+
+    std::string abs_path(const std::string& rel) const {
+        return rel.empty() ? root_ : root_ + "/" + rel;
+    }
+
+    std::string root_;
+    CgroupLimits limits_{-1, 0};
+    int inotify_fd_ = -1;
+    bool overflowed_ = false;
+    bool needs_rescan_ = false;
+    std::unordered_map<std::string, std::unique_ptr<CgroupEntry>> entries_;
+    std::unordered_map<int, std::string> path_by_wd_;
+};
+
+} // namespace
+
+bool get_cgroup_stats(const CgroupLimits& limits, std::vector<CgroupStats>& out) {
+    static CgroupTracker tracker;
+    return tracker.collect(limits, out);
+}
@@ -10,11 +10,22 @@
 #include <cstdint>
 #include <algorithm>
 #include "collector/cpu.h"
-
-// Cpu times struct to store all cpu usage types
-struct CpuTimes {
-    uint64_t user=0, nice=0, system=0, idle=0, iowait=0, irq=0, softirq=0, steal=0;
-};
+#include "metrics/time.h"
+
+// Fills the matching SystemCounters field from one '/proc/stat' line.
+// For "intr" only the first number (the grand total) is used.
+static void read_counter_line(const std::string& line, SystemCounters& c) {
+    std::istringstream iss(line);
+    std::string key;
+    uint64_t value = 0;
+    if (!(iss >> key >> value)) return;
+
+    if (key == "ctxt") c.ctxt = value;
+    else if (key == "intr") c.intr = value;
+    else if (key == "processes") c.processes = value;
+    else if (key == "procs_running") c.procs_running = value;
+    else if (key == "procs_blocked") c.procs_blocked = value;
+}
 
 
 // Reads file 'proc/stat' and extracts CPU stats
@@ -25,7 +36,10 @@ struct CpuTimes {
 // The function fills two outputs
 //  - per_cpu   -> a vecotr of CpuTimes for each core
 //  - total_out -> a CpuTimes for the cpu (all cores combined)
-static bool read_proc_stat(std::vector<CpuTimes>& per_cpu, CpuTimes& total_out) {
+// and, when 'counters' is given, the ctxt / intr / processes / procs_* lines
+// that follow the cpu block (otherwise reading stops after the cpu lines).
+static bool parse_proc_stat(std::vector<CpuTimes>& per_cpu, CpuTimes& total_out,
+                            SystemCounters* counters = nullptr) {
     // Open '/proc/stat' file for reading
     std::ifstream f("/proc/stat");
     if (!f.is_open()) return false;
@@ -36,7 +50,11 @@ static bool read_proc_stat(std::vector<CpuTimes>& per_cpu, CpuTimes& total_out)
 
     std::string line;
     while (std::getline(f, line)) {
-        if (line.rfind("cpu", 0) != 0) break; // stop at first non-cpu line
+        if (line.rfind("cpu", 0) != 0) {
+            if (!counters) break; // stop at first non-cpu line
+            read_counter_line(line, *counters);
+            continue;
+        }
 
 
         std::istringstream iss(line);
@@ -45,7 +63,8 @@ static bool read_proc_stat(std::vector<CpuTimes>& per_cpu, CpuTimes& total_out)
 
         // Initialize CpuTimes object "t" with all values from line read
         iss >> label
-            >> t.user >> t.nice >> t.system >> t.idle >> t.iowait >> t.irq >> t.softirq >> t.steal;
+            >> t.user >> t.nice >> t.system >> t.idle >> t.iowait >> t.irq >> t.softirq >> t.steal
+            >> t.guest >> t.guest_nice;
 
 
         // "cpu" line (w/ out the number) is the total aggregate usage
@@ -71,15 +90,34 @@ static inline uint64_t total_time(const CpuTimes& t) {
 }
 
 
+bool read_proc_stat(ProcStat& out) {
+    out.counters = SystemCounters{};
+    return parse_proc_stat(out.per_cpu, out.total, &out.counters);
+}
+
+
+// Raw active/total ticks, aggregate first
+bool read_cpu_ticks(std::vector<CpuTicks>& out) {
+    std::vector<CpuTimes> per_cpu;
+    CpuTimes total{};
+    if (!parse_proc_stat(per_cpu, total)) return false;
+
+    out.resize(per_cpu.size() + 1);
+    out[0] = CpuTicks{active_time(total), total_time(total)};
+    for (size_t i = 0; i < per_cpu.size(); ++i) {
+        out[i + 1] = CpuTicks{active_time(per_cpu[i]), total_time(per_cpu[i])};
+    }
+    return true;
+}
+
+
 // Gets cpu usage per core
-bool get_cpu_core_percent(std::vector<double>& out_core_pct) {
+bool get_cpu_core_percent(const ProcStat& stat, std::vector<double>& out_core_pct) {
     static std::vector<CpuTimes> last_per_cpu; // Stores previous cputimes
     static bool initialized = false;
 
-    std::vector<CpuTimes> cur_per_cpu;
-    CpuTimes ignore_total{};
-    // Reads the cpu statistics
-    if (!read_proc_stat(cur_per_cpu, ignore_total) || cur_per_cpu.empty()) return false;
+    const std::vector<CpuTimes>& cur_per_cpu = stat.per_cpu;
+    if (cur_per_cpu.empty()) return false;
 
     out_core_pct.resize(cur_per_cpu.size(), 0.0);
 
@@ -107,21 +145,17 @@ bool get_cpu_core_percent(std::vector<double>& out_core_pct) {
     }
 
     // Save current cpu usage for next calculation
-    last_per_cpu = std::move(cur_per_cpu);
+    last_per_cpu = cur_per_cpu;
     return true;
 }
 
 
 // Gets total cpu usage
-double get_cpu_total_percent() {
+double get_cpu_total_percent(const ProcStat& stat) {
     static CpuTimes last_total{}; // Stores last cpu usage information
     static bool initialized = false;
 
-    std::vector<CpuTimes> ignore_per_cpu;
-    CpuTimes cur_total{};
-
-    // Reads current cpu usage statistics
-    if (!read_proc_stat(ignore_per_cpu, cur_total)) return -1.0;
+    const CpuTimes& cur_total = stat.total;
 
     // If first read, initialize last_total and return 0
     if (!initialized) {
@@ -142,3 +176,149 @@ double get_cpu_total_percent() {
     if (d_total == 0) return 0.0;
     return 100.0 * (double)d_active / (double)d_total;
 }
+
+
+const char* cpu_mode_name(int mode) {
+    static constexpr const char* kNames[kCpuModeCount] = {
+            "user", "nice", "system", "idle", "iowait",
+            "irq", "softirq", "steal", "guest", "guest_nice"
+    };
+    return (mode >= 0 && mode < kCpuModeCount) ? kNames[mode] : "unknown";
+}
+
+// Split CpuTimes into disjoint mode counters (guest time removed from user/nice)
+static inline void mode_ticks(const CpuTimes& t, uint64_t (&out)[kCpuModeCount]) {
+    out[kCpuUser]      = t.user >= t.guest ? t.user - t.guest : 0;
+    out[kCpuNice]      = t.nice >= t.guest_nice ? t.nice - t.guest_nice : 0;
+    out[kCpuSystem]    = t.system;
+    out[kCpuIdle]      = t.idle;
+    out[kCpuIowait]    = t.iowait;
+    out[kCpuIrq]       = t.irq;
+    out[kCpuSoftirq]   = t.softirq;
+    out[kCpuSteal]     = t.steal;
+    out[kCpuGuest]     = t.guest;
+    out[kCpuGuestNice] = t.guest_nice;
+}
+
+// Fill one matrix row with the per-mode share of the a -> b interval
+static void mode_row(const CpuTimes& a, const CpuTimes& b, double* row) {
+    uint64_t ta[kCpuModeCount], tb[kCpuModeCount], d[kCpuModeCount];
+    mode_ticks(a, ta);
+    mode_ticks(b, tb);
+
+    uint64_t d_total = 0;
+    for (int m = 0; m < kCpuModeCount; ++m) {
+        d[m] = tb[m] >= ta[m] ? tb[m] - ta[m] : 0ULL;
+        d_total += d[m];
+    }
+    for (int m = 0; m < kCpuModeCount; ++m) {
+        row[m] = d_total == 0 ? 0.0 : 100.0 * (double)d[m] / (double)d_total;
+    }
+}
+
+// Gets the per-core and total mode breakdown
+bool get_cpu_mode_percent(const ProcStat& stat, std::vector<double>& out_matrix, size_t& out_cores) {
+    static std::vector<CpuTimes> last_per_cpu;
+    static CpuTimes last_total{};
+    static bool initialized = false;
+
+    const std::vector<CpuTimes>& cur_per_cpu = stat.per_cpu;
+    const CpuTimes& cur_total = stat.total;
+    if (cur_per_cpu.empty()) return false;
+
+    out_cores = cur_per_cpu.size();
+    out_matrix.assign((out_cores + 1) * kCpuModeCount, 0.0);
+
+    // First call, or CPUs went on/offline: re-baseline
+    if (!initialized || last_per_cpu.size() != cur_per_cpu.size()) {
+        last_per_cpu = cur_per_cpu;
+        last_total = cur_total;
+        initialized = true;
+        return true;
+    }
+
+    for (size_t i = 0; i < out_cores; ++i) {
+        mode_row(last_per_cpu[i], cur_per_cpu[i], &out_matrix[i * kCpuModeCount]);
+    }
+    mode_row(last_total, cur_total, &out_matrix[out_cores * kCpuModeCount]);
+
+    last_per_cpu = cur_per_cpu;
+    last_total = cur_total;
+    return true;
+}
+
+
+// Gets context switch / interrupt / fork rates and run-queue gauges
+void get_cpu_activity(const ProcStat& stat, CpuActivity& out) {
+    static SystemCounters last{};
+    static uint64_t last_time = 0;
+    static bool initialized = false;
+
+    const SystemCounters& cur = stat.counters;
+
+    const uint64_t time_now = tick_mono_ms();
+    out = CpuActivity{};
+    out.procs_running = cur.procs_running;
+    out.procs_blocked = cur.procs_blocked;
+
+    if (initialized && time_now > last_time) {
+        const double dt_s = (double)(time_now - last_time) / 1000.0;
+        out.ctxt_per_s  = cur.ctxt >= last.ctxt ? (double)(cur.ctxt - last.ctxt) / dt_s : 0.0;
+        out.intr_per_s  = cur.intr >= last.intr ? (double)(cur.intr - last.intr) / dt_s : 0.0;
+        out.forks_per_s = cur.processes >= last.processes ? (double)(cur.processes - last.processes) / dt_s : 0.0;
+    }
+
+    last = cur;
+    last_time = time_now;
+    initialized = true;
+}
+
+
+// Reads the per-cpu run_delay column (ns spent runnable but waiting) from
+// '/proc/schedstat'. Line format (version 15+):
+//   cpuN yld_count 0 sched_count sched_goidle ttwu_count ttwu_local rq_cpu_time run_delay pcount
+static bool read_schedstat_run_delay(std::vector<uint64_t>& out) {
+    std::ifstream f("/proc/schedstat");
+    if (!f.is_open()) return false;
+
+    out.clear();
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.rfind("cpu", 0) != 0) continue; // version / timestamp / domain lines
+
+        std::istringstream iss(line);
+        std::string label;
+        uint64_t field[8] = {};
+        iss >> label;
+        for (uint64_t& v : field) iss >> v;
+        if (!iss) continue;
+        out.push_back(field[7]);
+    }
+    return !out.empty();
+}
+
+// Gets per-core run-queue wait in ms per second
+bool get_cpu_runqueue_wait(std::vector<double>& out_wait_ms) {
+    static std::vector<uint64_t> last_delay;
+    static uint64_t last_time = 0;
+
+    std::vector<uint64_t> cur_delay;
+    if (!read_schedstat_run_delay(cur_delay)) return false;
+    const uint64_t time_now = tick_mono_ms();
+
+    // First call, or CPUs went on/offline: re-baseline
+    if (last_delay.size() != cur_delay.size() || time_now <= last_time) {
+        out_wait_ms.assign(cur_delay.size(), 0.0);
+    } else {
+        const double dt_s = (double)(time_now - last_time) / 1000.0;
+        out_wait_ms.resize(cur_delay.size());
+        for (size_t i = 0; i < cur_delay.size(); ++i) {
+            const uint64_t d_ns = cur_delay[i] >= last_delay[i] ? cur_delay[i] - last_delay[i] : 0ULL;
+            out_wait_ms[i] = (double)d_ns / 1e6 / dt_s;
+        }
+    }
+
+    last_delay = std::move(cur_delay);
+    last_time = time_now;
+    return true;
+}
@@ -0,0 +1,55 @@
+//
+// deadline_linux.cpp — timerfd-backed DeadlineTimer and the tick grid.
+//
+#include "collector/deadline.h"
+
+#include <cerrno>
+#include <chrono>
+#include <sys/timerfd.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+#include "metrics/time.h"
+
+DeadlineTimer::DeadlineTimer() {
+    fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+}
+
+DeadlineTimer::~DeadlineTimer() {
+    if (fd_ >= 0) close(fd_);
+}
+
+void DeadlineTimer::wait_until(int64_t deadline_ms) {
+    if (deadline_ms <= mono_ms()) return;
+
+    if (fd_ >= 0) {
+        itimerspec spec{};
+        spec.it_value.tv_sec = deadline_ms / 1000;
+        spec.it_value.tv_nsec = (deadline_ms % 1000) * 1000000;
+        if (timerfd_settime(fd_, TFD_TIMER_ABSTIME, &spec, nullptr) == 0) {
+            uint64_t expirations = 0;
+            while (read(fd_, &expirations, sizeof(expirations)) < 0 && errno == EINTR) {}
+            return;
+        }
+    }
+
+    // No timerfd (seccomp, very old kernel): steady_clock is CLOCK_MONOTONIC too
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::milliseconds(deadline_ms)));
+}
+
+TickSchedule::TickSchedule(int64_t period_ms) : period_ms_(period_ms > 0 ? period_ms : 1000) {
+    // First deadline at the next wall-clock multiple of the period
+    const int64_t wall = now_ms();
+    next_deadline_ = mono_ms() + (period_ms_ - wall % period_ms_);
+}
+
+int64_t TickSchedule::advance(int64_t now_mono_ms) {
+    next_deadline_ += period_ms_;
+    if (next_deadline_ > now_mono_ms) return 0;
+
+    // Overran: stay on the grid and skip the deadlines already in the past
+    const int64_t skipped = (now_mono_ms - next_deadline_) / period_ms_ + 1;
+    next_deadline_ += skipped * period_ms_;
+    return skipped;
+}
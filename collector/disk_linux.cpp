@@ -8,11 +8,11 @@
 #include <unordered_map>
 #include <stdio.h>
 #include "metrics/time.h"
+#include "store/runtime_config.h"
 #include <sstream>
 #include <collector/disk.h>
 
 
-constexpr bool AGGREGATE_PARTITIONS = true;
 
 inline bool is_counted_device(const std::string& n){
 
@@ -103,7 +103,7 @@ bool get_disk_io(std::vector<DiskIO>& output){
         return false;
     }
 
-    const u_int64_t time_now = now_ms();
+    const u_int64_t time_now = tick_mono_ms();
 
     std::unordered_map<std::string, DiskInfo> curr_values;
     curr_values.reserve(curr_rows.size()); // We know they'll be the same size
@@ -152,7 +152,7 @@ bool get_disk_io(std::vector<DiskIO>& output){
     }
 
     std::unordered_map<std::string, Delta> by_key;
-    if (AGGREGATE_PARTITIONS) {
+    if (runtime_config()->disk_aggregate_partitions) {
         for (const auto& [name, d] : deltas) {
             std::string key = base_device_name(name);
 
@@ -0,0 +1,171 @@
+//
+// executor.cpp — lane threads for CollectorExecutor.
+//
+#include "collector/executor.h"
+
+#include <algorithm>
+#include <sys/resource.h>
+#include <thread>
+
+#include "collector/deadline.h"
+#include "metrics/time.h"
+
+namespace {
+
+// Lanes re-check the stop flag at least this often, even when their next
+// task is far away (e.g. a 30 s filesystem scan).
+constexpr int64_t kMaxSleepMs = 1000;
+
+} // namespace
+
+int64_t thread_cpu_us() {
+#ifdef RUSAGE_THREAD
+    rusage ru{};
+    if (getrusage(RUSAGE_THREAD, &ru) != 0) return 0;
+    return int64_t(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000 +
+           int64_t(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec);
+#else
+    return 0;
+#endif
+}
+
+struct CollectorExecutor::Scheduled {
+    const CollectorTask* task;
+    TickSchedule schedule;
+    bool paused = false;
+};
+
+// Re-phase tasks whose effective period changed and pick up pause flags.
+void CollectorExecutor::apply_controls(std::vector<Scheduled>& lane) {
+    std::scoped_lock lk(control_mtx_);
+    for (Scheduled& s : lane) {
+        const Control& c = controls_[s.task->name];
+        const int64_t period = std::max<int64_t>(1, int64_t(double(c.period_ms) * c.scale));
+        if (period != s.schedule.period_ms()) s.schedule = TickSchedule(period);
+        s.paused = c.paused;
+    }
+}
+
+void CollectorExecutor::run_lane(std::vector<Scheduled> lane,
+                                 std::atomic<bool>& running,
+                                 const std::function<void(const TaskRun&)>& observer) {
+    DeadlineTimer timer;
+    unsigned seen_generation = control_generation_.load();
+    apply_controls(lane);
+    while (running.load(std::memory_order_relaxed)) {
+        if (const unsigned generation = control_generation_.load(); generation != seen_generation) {
+            seen_generation = generation;
+            apply_controls(lane);
+        }
+
+        auto next = std::min_element(lane.begin(), lane.end(), [](const Scheduled& a, const Scheduled& b) {
+            return a.schedule.next_deadline() < b.schedule.next_deadline();
+        });
+        const int64_t deadline = next->schedule.next_deadline();
+        timer.wait_until(std::min(deadline, mono_ms() + kMaxSleepMs));
+        if (!running.load(std::memory_order_relaxed)) break;
+
+        const int64_t start_us = mono_us();
+        const int64_t start = start_us / 1000;
+        if (start < deadline) continue;
+        if (next->paused) {
+            next->schedule.advance(start);
+            continue;
+        }
+
+        set_tick_mono_ms(start);
+        TaskRun run;
+        run.task = next->task;
+        run.timestamp_ms = now_ms();
+        const int64_t cpu_start_us = thread_cpu_us();
+        run.items = next->task->run(run.timestamp_ms);
+        run.cpu_us = thread_cpu_us() - cpu_start_us;
+
+        const int64_t end_us = mono_us();
+        const int64_t end = end_us / 1000;
+        const int64_t budget = next->task->deadline_ms > 0 ? next->task->deadline_ms : next->schedule.period_ms();
+        run.duration_us = end_us - start_us;
+        run.start_lag_us = start_us - deadline * 1000;
+        run.lateness_us = std::max<int64_t>(0, end_us - (deadline + budget) * 1000);
+        run.late = end > deadline + budget;
+        run.missed = next->schedule.advance(end);
+        if (observer) observer(run);
+    }
+}
+
+void CollectorExecutor::add(CollectorTask task) {
+    {
+        std::scoped_lock lk(control_mtx_);
+        Control& c = controls_[task.name];
+        c.period_ms = task.period_ms;
+        c.added_period_ms = task.period_ms;
+    }
+    tasks_.push_back(std::move(task));
+}
+
+void CollectorExecutor::set_period(const std::string& task, int64_t period_ms) {
+    std::scoped_lock lk(control_mtx_);
+    auto it = controls_.find(task);
+    if (it == controls_.end()) return;
+    if (period_ms <= 0) period_ms = it->second.added_period_ms;
+    if (it->second.period_ms == period_ms) return;
+    it->second.period_ms = period_ms;
+    control_generation_.fetch_add(1);
+}
+
+void CollectorExecutor::set_period_scale(const std::string& task, double scale) {
+    std::scoped_lock lk(control_mtx_);
+    auto it = controls_.find(task);
+    if (it == controls_.end()) return;
+    scale = std::max(1.0, scale);
+    if (it->second.scale == scale) return;
+    it->second.scale = scale;
+    control_generation_.fetch_add(1);
+}
+
+void CollectorExecutor::set_paused(const std::string& task, bool paused) {
+    std::scoped_lock lk(control_mtx_);
+    auto it = controls_.find(task);
+    if (it == controls_.end() || it->second.paused == paused) return;
+    it->second.paused = paused;
+    control_generation_.fetch_add(1);
+}
+
+int64_t CollectorExecutor::shortest_period_ms(int lane) const {
+    std::scoped_lock lk(control_mtx_);
+    int64_t shortest = 0;
+    for (const CollectorTask& task : tasks_) {
+        if (task.lane != lane) continue;
+        auto it = controls_.find(task.name);
+        const int64_t period = it == controls_.end() ? task.period_ms : it->second.period_ms;
+        if (shortest == 0 || period < shortest) shortest = period;
+    }
+    return shortest;
+}
+
+std::vector<std::string> CollectorExecutor::task_names() const {
+    std::scoped_lock lk(control_mtx_);
+    std::vector<std::string> names;
+    names.reserve(controls_.size());
+    for (const auto& [name, control] : controls_) names.push_back(name);
+    return names;
+}
+
+void CollectorExecutor::run(std::atomic<bool>& running, const std::function<void(const TaskRun&)>& observer) {
+    int lane_count = 0;
+    for (const CollectorTask& task : tasks_) lane_count = std::max(lane_count, task.lane + 1);
+
+    std::vector<std::vector<Scheduled>> lanes(static_cast<size_t>(lane_count));
+    for (const CollectorTask& task : tasks_) {
+        lanes[size_t(std::max(task.lane, 0))].push_back(Scheduled{&task, TickSchedule(task.period_ms)});
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < lanes.size(); ++i) {
+        if (lanes[i].empty()) continue;
+        threads.emplace_back(&CollectorExecutor::run_lane, this, std::move(lanes[i]), std::ref(running), std::cref(observer));
+    }
+    if (!lanes.empty() && !lanes[0].empty()) run_lane(std::move(lanes[0]), running, observer);
+
+    for (std::thread& t : threads) t.join();
+}
@@ -0,0 +1,233 @@
+//
+// fs_linux.cpp — filesystem capacity collector.
+//
+// /proc/self/mountinfo stays open; the kernel flags it with POLLPRI|POLLERR
+// whenever the mount table changes, so the (long) file is only re-parsed then.
+// statvfs can block indefinitely on a dead NFS/FUSE server, so the calls run on
+// a long-lived helper thread and the sampler waits at most kStatvfsTimeout per
+// mount. A mount whose call is still pending is skipped on later ticks, and the
+// helper stuck in it is replaced for them.
+//
+#include "collector/fs.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/statvfs.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace {
+
+constexpr auto kStatvfsTimeout = std::chrono::milliseconds(200);
+
+// Pseudo, virtual, container-layer and network filesystems we never report.
+const std::unordered_set<std::string> kSkippedFsTypes = {
+        // pseudo / virtual
+        "proc", "sysfs", "devtmpfs", "devpts", "tmpfs", "ramfs", "cgroup", "cgroup2",
+        "pstore", "bpf", "tracefs", "debugfs", "securityfs", "configfs", "fusectl",
+        "mqueue", "hugetlbfs", "autofs", "binfmt_misc", "rpc_pipefs", "nsfs", "efivarfs",
+        "selinuxfs", "overlay", "squashfs", "iso9660", "fuse.lxcfs", "fuse.portal",
+        // network
+        "nfs", "nfs4", "cifs", "smb3", "smbfs", "ceph", "glusterfs", "fuse.glusterfs",
+        "fuse.sshfs", "fuse.s3fs", "9p", "afs", "lustre", "gpfs", "ocfs2", "gfs2",
+};
+
+struct MountEntry {
+    std::string mount;
+    std::string fstype;
+};
+
+// mountinfo escapes space, tab, newline and backslash as \ooo
+std::string unescape_mount_path(const std::string& raw) {
+    std::string out;
+    out.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+        if (raw[i] == '\\' && i + 3 < raw.size()) {
+            const char a = raw[i + 1], b = raw[i + 2], c = raw[i + 3];
+            if (a >= '0' && a <= '7' && b >= '0' && b <= '7' && c >= '0' && c <= '7') {
+                out.push_back(static_cast<char>((a - '0') * 64 + (b - '0') * 8 + (c - '0')));
+                i += 3;
+                continue;
+            }
+        }
+        out.push_back(raw[i]);
+    }
+    return out;
+}
+
+// Parse mountinfo, keeping the first mount of each block device.
+// Line: id parent major:minor root mountpoint opts [optional...] - fstype source superopts
+bool parse_mountinfo(int fd, std::vector<MountEntry>& mounts) {
+    std::string content;
+    char buf[16384];
+    off_t off = 0;
+    ssize_t n;
+    while ((n = pread(fd, buf, sizeof(buf), off)) > 0) {
+        content.append(buf, size_t(n));
+        off += n;
+    }
+    if (content.empty()) return false;
+
+    mounts.clear();
+    std::unordered_set<std::string> seen_devices;
+    std::istringstream lines(content);
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::istringstream fields(line);
+        std::string id, parent, devno, root, mount_point;
+        if (!(fields >> id >> parent >> devno >> root >> mount_point)) continue;
+
+        std::string token, fstype;
+        while (fields >> token && token != "-") {}
+        if (!(fields >> fstype)) continue;
+
+        if (kSkippedFsTypes.count(fstype)) continue;
+        if (!seen_devices.insert(devno).second) continue;  // bind mounts / subvolume duplicates
+
+        mounts.push_back(MountEntry{unescape_mount_path(mount_point), fstype});
+    }
+    return true;
+}
+
+// Results of one batch of statvfs calls, shared with the helper thread so a
+// hung call can outlive the collector's wait.
+struct StatvfsBatch {
+    std::mutex m;
+    std::condition_variable cv;
+    std::vector<MountEntry> mounts;
+    std::vector<struct statvfs> results;
+    std::vector<bool> ok;
+    size_t completed = 0;
+};
+
+// Mount points whose statvfs is still pending from an earlier tick
+std::mutex g_hung_mtx;
+std::unordered_set<std::string> g_hung;
+
+bool is_hung(const std::string& path) {
+    std::scoped_lock lk(g_hung_mtx);
+    return g_hung.count(path) != 0;
+}
+
+void run_statvfs_batch(StatvfsBatch& batch) {
+    for (size_t i = 0; i < batch.mounts.size(); ++i) {
+        struct statvfs st{};
+        const bool ok = statvfs(batch.mounts[i].mount.c_str(), &st) == 0;
+
+        std::scoped_lock lk(batch.m);
+        batch.results[i] = st;
+        batch.ok[i] = ok;
+        batch.completed = i + 1;
+        batch.cv.notify_all();
+
+        // If the collector gave up on us, this path was marked hung; clear it now
+        std::scoped_lock hk(g_hung_mtx);
+        g_hung.erase(batch.mounts[i].mount);
+    }
+}
+
+// Runs one batch per sweep. Once abandoned (a call outlived the sweep's
+// timeout) it finishes that batch and exits; the next sweep starts another.
+struct StatvfsWorker {
+    std::mutex m;
+    std::condition_variable cv;
+    std::shared_ptr<StatvfsBatch> pending;
+    bool abandoned = false;
+};
+
+std::shared_ptr<StatvfsWorker> start_statvfs_worker() {
+    auto worker = std::make_shared<StatvfsWorker>();
+    std::thread([worker] {
+        std::unique_lock<std::mutex> lk(worker->m);
+        while (true) {
+            worker->cv.wait(lk, [&] { return worker->pending != nullptr; });
+            const std::shared_ptr<StatvfsBatch> batch = std::move(worker->pending);
+            lk.unlock();
+            run_statvfs_batch(*batch);
+            lk.lock();
+            if (worker->abandoned) return;
+        }
+    }).detach();
+    return worker;
+}
+
+} // namespace
+
+bool get_fs_usage(std::vector<FsUsage>& out) {
+    static int mountinfo_fd = -1;
+    static std::vector<MountEntry> mounts;
+    static std::shared_ptr<StatvfsWorker> worker;
+
+    if (mountinfo_fd < 0) {
+        mountinfo_fd = open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+        if (mountinfo_fd < 0) return false;
+        if (!parse_mountinfo(mountinfo_fd, mounts)) return false;
+    } else {
+        pollfd pfd{mountinfo_fd, POLLPRI, 0};
+        if (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLPRI | POLLERR))) {
+            if (!parse_mountinfo(mountinfo_fd, mounts)) return false;
+        }
+    }
+
+    auto batch = std::make_shared<StatvfsBatch>();
+    for (const auto& m : mounts) {
+        if (!is_hung(m.mount)) batch->mounts.push_back(m);
+    }
+    batch->results.resize(batch->mounts.size());
+    batch->ok.assign(batch->mounts.size(), false);
+
+    if (!worker) worker = start_statvfs_worker();
+    {
+        std::scoped_lock wk(worker->m);
+        worker->pending = batch;
+    }
+    worker->cv.notify_one();
+
+    // Wait up to kStatvfsTimeout for each successive mount
+    std::unique_lock<std::mutex> lk(batch->m);
+    size_t seen = 0;
+    while (seen < batch->mounts.size()) {
+        if (!batch->cv.wait_for(lk, kStatvfsTimeout, [&] { return batch->completed > seen; })) {
+            {
+                std::scoped_lock hk(g_hung_mtx);
+                g_hung.insert(batch->mounts[batch->completed].mount);
+            }
+            {
+                std::scoped_lock wk(worker->m);
+                worker->abandoned = true;
+            }
+            worker = nullptr;
+            break;
+        }
+        seen = batch->completed;
+    }
+
+    out.clear();
+    for (size_t i = 0; i < seen; ++i) {
+        if (!batch->ok[i]) continue;
+        const MountEntry& m = batch->mounts[i];
+
+        const struct statvfs& st = batch->results[i];
+        if (st.f_blocks == 0) continue;  // nothing to report (e.g. autofs placeholders)
+
+        const uint64_t frsize = st.f_frsize ? st.f_frsize : st.f_bsize;
+        FsUsage u;
+        u.mount = m.mount;
+        u.fstype = m.fstype;
+        u.size_bytes = uint64_t(st.f_blocks) * frsize;
+        u.used_bytes = uint64_t(st.f_blocks - st.f_bfree) * frsize;
+        u.avail_bytes = uint64_t(st.f_bavail) * frsize;
+        u.inodes_total = st.f_files;
+        u.inodes_free = st.f_ffree;
+        u.inodes_used = st.f_files >= st.f_ffree ? st.f_files - st.f_ffree : 0;
+        out.push_back(std::move(u));
+    }
+    return true;
+}
@@ -0,0 +1,125 @@
+//
+// governor.cpp — SamplerGovernor windows and degradation levels.
+//
+// The lane threads are charged through their TaskRuns and the burst capture
+// thread through charge(). Work the lanes hand off (the netns helper, statvfs
+// threads) is small next to the process scan, which dominates the sampler's
+// CPU time and is the first thing slowed down.
+//
+#include "collector/governor.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+#include "config.h"
+#include "metrics/metric_key.h"
+#include "metrics/time.h"
+
+namespace {
+
+struct DegradationStep {
+    const char* name;
+    double process_scale;       // process task period multiplier
+    size_t table_divisor;       // process table rows divided by
+    double optional_scale;      // period multiplier for kOptionalTasks
+    bool pause_optional;        // kOptionalTasks stop (filesystem keeps running, scaled)
+    int64_t burst_divisor;      // burst capture window divided by; 0: no captures
+};
+
+constexpr DegradationStep kSteps[] = {
+        {"normal", 1, 1, 1, false, 1},
+        {"slow_process", 2, 2, 1, false, 2},
+        {"slow_optional", 4, 4, 4, false, 0},
+        {"skip_optional", 8, 4, 4, true, 0},
+};
+constexpr int kMaxLevel = int(std::size(kSteps)) - 1;
+
+constexpr const char* kOptionalTasks[] = {"irq", "sensors", "netns", "cgroup"};
+
+} // namespace
+
+SamplerGovernor::SamplerGovernor(CollectorExecutor& executor, MemoryStore& store, GovernorConfig config)
+        : executor_(executor), store_(store), config_(config) {
+    store_.put_snapshot("governor", {
+            {"enabled", config_.budget_pct > 0},
+            {"budget_pct", config_.budget_pct},
+            {"level", 0},
+            {"state", kSteps[0].name}
+    });
+}
+
+size_t SamplerGovernor::process_table_limit(size_t configured) const {
+    return std::max<size_t>(1, configured / kSteps[level()].table_divisor);
+}
+
+int64_t SamplerGovernor::burst_window_ms(int64_t configured) const {
+    if (config_.budget_pct <= 0) return configured;
+    const int64_t divisor = kSteps[level()].burst_divisor;
+    return divisor > 0 ? configured / divisor : 0;
+}
+
+void SamplerGovernor::charge(int64_t cpu_us) {
+    if (config_.budget_pct <= 0) return;
+
+    std::scoped_lock lk(m_);
+    window_cpu_us_ += cpu_us;
+}
+
+void SamplerGovernor::observe(const TaskRun& run) {
+    if (config_.budget_pct <= 0) return;
+
+    const int64_t mono_now = mono_ms();
+    std::scoped_lock lk(m_);
+    if (window_start_ms_ == 0) window_start_ms_ = mono_now;
+    window_cpu_us_ += run.cpu_us;
+    if (mono_now - window_start_ms_ >= config_.window_ms) close_window(mono_now, run.timestamp_ms);
+}
+
+// Caller holds m_.
+void SamplerGovernor::close_window(int64_t mono_now_ms, int64_t timestamp_ms) {
+    const double elapsed_us = double(mono_now_ms - window_start_ms_) * 1000.0;
+    const double cpu_pct = 100.0 * double(window_cpu_us_) / elapsed_us;
+    window_start_ms_ = mono_now_ms;
+    window_cpu_us_ = 0;
+
+    int level = level_.load(std::memory_order_relaxed);
+    if (cpu_pct > config_.budget_pct) {
+        calm_ = 0;
+        if (level < kMaxLevel) ++level;
+    } else if (cpu_pct < config_.budget_pct / 2 && level > 0) {
+        if (++calm_ >= config_.calm_windows) {
+            calm_ = 0;
+            --level;
+        }
+    } else {
+        calm_ = 0;
+    }
+
+    if (level != level_.load(std::memory_order_relaxed)) {
+        apply_level(level);
+        changed_ms_ = timestamp_ms;
+    }
+
+    store_.append(metric_with_labels("self.cpu_pct", {{"host", cfg::HOST_LABEL}}), timestamp_ms, cpu_pct);
+    store_.append(metric_with_labels("self.degradation_level", {{"host", cfg::HOST_LABEL}}), timestamp_ms, double(level));
+    store_.put_snapshot("governor", {
+            {"enabled", true},
+            {"budget_pct", config_.budget_pct},
+            {"cpu_pct", cpu_pct},
+            {"level", level},
+            {"state", kSteps[level].name},
+            {"changed_ms", changed_ms_}
+    });
+}
+
+void SamplerGovernor::apply_level(int level) {
+    const DegradationStep& step = kSteps[level];
+    executor_.set_period_scale("process", step.process_scale);
+    executor_.set_period_scale("filesystem", step.optional_scale);
+    for (const char* task : kOptionalTasks) {
+        executor_.set_period_scale(task, step.optional_scale);
+        executor_.set_paused(task, step.pause_optional);
+    }
+    level_.store(level, std::memory_order_relaxed);
+}
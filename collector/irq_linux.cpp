@@ -0,0 +1,220 @@
+//
+// irq_linux.cpp — /proc/interrupts and /proc/softirqs column parser.
+//
+// Both files print every counter as " %10u", so on a 256-CPU box a row is
+// 256 fixed 11-byte fields. Instead of tokenizing, each field is decoded with
+// SWAR arithmetic: spaces are OR'ed into '0', validated eight bytes at a time,
+// and folded into an integer with three multiply/shift steps. Any field that
+// does not fit the fixed layout (a counter wider than 10 digits) drops the
+// rest of that row to a scalar parser.
+//
+#include "collector/irq.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string_view>
+#include <unistd.h>
+
+#include "metrics/time.h"
+
+namespace {
+
+constexpr size_t kFieldWidth = 11;  // " %10u"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+// Decode a right-aligned 10-char counter (space padded). false if any byte
+// is not a digit or space.
+inline bool parse_field10(const char* p, uint64_t& out) {
+    uint64_t lo;
+    uint16_t hi;
+    std::memcpy(&hi, p, 2);
+    std::memcpy(&lo, p + 2, 8);
+
+    // ' ' (0x20) -> '0' (0x30); digits are unchanged
+    lo |= 0x1010101010101010ULL;
+    hi |= 0x1010;
+
+    // Every byte must be 0x30..0x39: high nibble 3, and still 3 after adding 6
+    if ((lo & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL) return false;
+    if (((lo + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL) return false;
+    if ((hi & 0xF0F0) != 0x3030 || ((hi + 0x0606) & 0xF0F0) != 0x3030) return false;
+
+    lo -= 0x3030303030303030ULL;
+    lo = (lo * 10 + (lo >> 8)) & 0x00FF00FF00FF00FFULL;
+    lo = (lo * 100 + (lo >> 16)) & 0x0000FFFF0000FFFFULL;
+    lo = (lo * 10000 + (lo >> 32)) & 0x00000000FFFFFFFFULL;
+
+    const uint64_t high_digits = uint64_t((hi & 0xFF) - '0') * 10 + uint64_t((hi >> 8) - '0');
+    out = high_digits * 100000000ULL + lo;
+    return true;
+}
+#else
+inline bool parse_field10(const char*, uint64_t&) { return false; }
+#endif
+
+// Scalar fallback: skip blanks, read digits. false if no digits.
+inline bool parse_scalar(const char*& p, const char* end, uint64_t& out) {
+    while (p < end && *p == ' ') ++p;
+    if (p == end || *p < '0' || *p > '9') return false;
+    uint64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + uint64_t(*p++ - '0');
+    out = v;
+    return true;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+// Parsed layout + counters of one file; rows keep file order.
+struct IrqTable {
+    const char* path;
+    int fd = -2;
+    std::vector<char> buf;
+
+    size_t ncpu = 0;
+    std::vector<std::string> names;
+    std::vector<std::string> descs;
+    std::vector<uint64_t> counts;       // rows x ncpu
+    std::vector<uint64_t> prev_counts;
+    std::vector<bool> ever_moved;
+    uint64_t prev_time = 0;
+    bool have_prev = false;
+
+    explicit IrqTable(const char* p) : path(p) {}
+};
+
+bool read_whole(IrqTable& t, size_t& len) {
+    if (t.fd == -2) t.fd = open(t.path, O_RDONLY | O_CLOEXEC);
+    if (t.fd < 0) return false;
+    if (t.buf.empty()) t.buf.resize(64 * 1024);
+
+    len = 0;
+    while (true) {
+        if (len == t.buf.size()) t.buf.resize(t.buf.size() * 2);
+        const ssize_t n = pread(t.fd, t.buf.data() + len, t.buf.size() - len, off_t(len));
+        if (n < 0) return false;
+        if (n == 0) break;
+        len += size_t(n);
+    }
+    return len > 0;
+}
+
+// Parse the file into t.counts. Returns false on read error. 'layout_changed'
+// is set when rows or CPU count differ from the previous parse, 'names_changed'
+// when the row names do.
+bool parse_table(IrqTable& t, bool& layout_changed, bool& names_changed) {
+    size_t len = 0;
+    if (!read_whole(t, len)) return false;
+
+    const char* p = t.buf.data();
+    const char* end = p + len;
+
+    // Header: "           CPU0       CPU1 ..."
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+    if (!eol) return false;
+    size_t ncpu = 0;
+    for (const char* q = p; q + 3 <= eol; ++q) {
+        if (q[0] == 'C' && q[1] == 'P' && q[2] == 'U') ++ncpu;
+    }
+    if (ncpu == 0) return false;
+
+    layout_changed = ncpu != t.ncpu;
+    t.ncpu = ncpu;
+
+    size_t row = 0;
+    for (p = eol + 1; p < end; p = eol + 1) {
+        eol = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+        if (!eol) eol = end;
+
+        const char* colon = static_cast<const char*>(std::memchr(p, ':', size_t(eol - p)));
+        if (!colon) continue;
+
+        // Decode ncpu counters; rows like "ERR:" / "MIS:" carry a single value and are skipped
+        if (t.counts.size() < (row + 1) * ncpu) t.counts.resize((row + 1) * ncpu);
+        uint64_t* dst = &t.counts[row * ncpu];
+
+        const char* f = colon + 1;
+        size_t col = 0;
+        for (; col < ncpu && f + kFieldWidth <= eol && *f == ' ' && parse_field10(f + 1, dst[col]); ++col) {
+            f += kFieldWidth;
+        }
+        for (; col < ncpu && parse_scalar(f, eol, dst[col]); ++col) {}
+        if (col != ncpu) continue;
+
+        const std::string_view name = trim(std::string_view(p, size_t(colon - p)));
+        if (row >= t.names.size() || t.names[row] != name) {
+            layout_changed = true;
+            names_changed = true;
+            if (row >= t.names.size()) {
+                t.names.resize(row + 1);
+                t.descs.resize(row + 1);
+            }
+            t.names[row].assign(name);
+            t.descs[row].assign(trim(std::string_view(f, size_t(eol - f))));
+        }
+        ++row;
+    }
+
+    if (row != t.names.size()) layout_changed = names_changed = true;
+    t.names.resize(row);
+    t.descs.resize(row);
+    t.counts.resize(row * ncpu);
+    return true;
+}
+
+bool get_rates(IrqTable& t, std::vector<IrqRates>& out) {
+    bool layout_changed = false;
+    bool names_changed = false;
+    if (!parse_table(t, layout_changed, names_changed)) return false;
+
+    const uint64_t time_now = tick_mono_ms();
+    out.clear();
+
+    if (layout_changed || !t.have_prev) {
+        // New baseline; rows that moved before stay reported unless the rows
+        // themselves changed (a flag would then belong to another line)
+        if (names_changed || t.ever_moved.size() != t.names.size()) t.ever_moved.assign(t.names.size(), false);
+    } else if (time_now > t.prev_time) {
+        const double dt_s = double(time_now - t.prev_time) / 1000.0;
+        for (size_t row = 0; row < t.names.size(); ++row) {
+            const uint64_t* cur = &t.counts[row * t.ncpu];
+            const uint64_t* prev = &t.prev_counts[row * t.ncpu];
+
+            bool moved = t.ever_moved[row];
+            for (size_t c = 0; c < t.ncpu && !moved; ++c) moved = cur[c] != prev[c];
+            if (!moved) continue;
+            t.ever_moved[row] = true;
+
+            IrqRates rates;
+            rates.name = t.names[row];
+            rates.desc = t.descs[row];
+            rates.per_cpu.resize(t.ncpu);
+            for (size_t c = 0; c < t.ncpu; ++c) {
+                rates.per_cpu[c] = cur[c] >= prev[c] ? double(cur[c] - prev[c]) / dt_s : 0.0;
+                rates.total += rates.per_cpu[c];
+            }
+            out.push_back(std::move(rates));
+        }
+    }
+
+    t.prev_counts.swap(t.counts);
+    t.prev_time = time_now;
+    t.have_prev = true;
+    return true;
+}
+
+} // namespace
+
+bool get_interrupt_rates(std::vector<IrqRates>& out) {
+    static IrqTable table("/proc/interrupts");
+    return get_rates(table, out);
+}
+
+bool get_softirq_rates(std::vector<IrqRates>& out) {
+    static IrqTable table("/proc/softirqs");
+    return get_rates(table, out);
+}
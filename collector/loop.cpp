@@ -8,45 +8,201 @@
 
 #include "collector/loop.h"
 
+#include "collector/burst.h"
+#include "collector/cgroup.h"
 #include "collector/cpu.h"
+#include "collector/executor.h"
 #include "collector/disk.h"
+#include "collector/fs.h"
+#include "collector/governor.h"
+#include "collector/irq.h"
 #include "collector/memory.h"
 #include "collector/net.h"
+#include "collector/netns.h"
+#include "collector/pressure.h"
 #include "collector/proc.h"
+#include "collector/sensors.h"
+#include "collector/telemetry.h"
+#include "collector/vmstat.h"
 #include "config.h"
 #include "metrics/metric_key.h"
+#include "store/runtime_config.h"
 #include "metrics/time.h"
 #include "third_party/json.hpp"
 
 namespace {
 using json = nlohmann::json;
 
-constexpr size_t kProcessTableLimit = 128;
 
 std::string selector_for(const std::string& metric_name,
                          const std::initializer_list<std::pair<std::string, std::string>>& labels) {
     return metric_with_labels(metric_name, labels);
 }
 
-void sample_cpu_metrics(MemoryStore& store, int64_t timestamp_ms, std::vector<double>& core_percent_buffer) {
+// Row labels for cpu.mode_pct: "0".."N-1" then "total"
+MatrixShape cpu_mode_shape(size_t cores) {
+    MatrixShape shape;
+    shape.rows.reserve(cores + 1);
+    for (size_t core = 0; core < cores; ++core) shape.rows.push_back(std::to_string(core));
+    shape.rows.emplace_back("total");
+    for (int mode = 0; mode < kCpuModeCount; ++mode) shape.columns.emplace_back(cpu_mode_name(mode));
+    return shape;
+}
+
+void sample_cpu_metrics(MemoryStore& store,
+                        int64_t timestamp_ms,
+                        const ProcStat& stat,
+                        std::vector<double>& core_percent_buffer,
+                        std::vector<double>& mode_matrix_buffer,
+                        size_t& mode_matrix_cores,
+                        BurstCapture& burst) {
     const std::string total_cpu_selector = selector_for("cpu.total_pct", {{"host", cfg::HOST_LABEL}});
-    if (double total_percent = get_cpu_total_percent(); total_percent >= 0.0) {
-        store.append(total_cpu_selector, timestamp_ms, total_percent);
-    }
+    const double total_percent = get_cpu_total_percent(stat);
+    store.append(total_cpu_selector, timestamp_ms, total_percent);
+    burst.observe_cpu(total_percent);
 
     const std::string core_cpu_selector = selector_for("cpu.core_pct", {{"host", cfg::HOST_LABEL}});
-    if (get_cpu_core_percent(core_percent_buffer)) {
+    if (get_cpu_core_percent(stat, core_percent_buffer)) {
         store.append_vector(core_cpu_selector, timestamp_ms, core_percent_buffer);
     }
+
+    // One matrix append per tick covers every core x mode plus the total row
+    const std::string mode_selector = selector_for("cpu.mode_pct", {{"host", cfg::HOST_LABEL}});
+    if (size_t cores = 0; get_cpu_mode_percent(stat, mode_matrix_buffer, cores)) {
+        if (cores != mode_matrix_cores) {
+            store.define_matrix(mode_selector, cpu_mode_shape(cores));
+            mode_matrix_cores = cores;
+        }
+        store.append_vector(mode_selector, timestamp_ms, mode_matrix_buffer);
+    }
+}
+
+// Run-queue pressure: /proc/stat activity counters ('stat' is null when the
+// file could not be read) plus per-core wait from schedstat
+void sample_scheduler_metrics(MemoryStore& store, int64_t timestamp_ms, const ProcStat* stat,
+                              std::vector<double>& runq_wait_buffer) {
+    if (stat) {
+        CpuActivity activity;
+        get_cpu_activity(*stat, activity);
+        auto append = [&](const char* metric, double value) {
+            store.append(selector_for(metric, {{"host", cfg::HOST_LABEL}}), timestamp_ms, value);
+        };
+        append("sched.ctxt", activity.ctxt_per_s);
+        append("sched.intr", activity.intr_per_s);
+        append("sched.forks", activity.forks_per_s);
+        append("sched.procs_running", static_cast<double>(activity.procs_running));
+        append("sched.procs_blocked", static_cast<double>(activity.procs_blocked));
+    }
+
+    if (get_cpu_runqueue_wait(runq_wait_buffer)) {
+        store.append_vector(selector_for("sched.runq_wait", {{"host", cfg::HOST_LABEL}}), timestamp_ms, runq_wait_buffer);
+    }
+}
+
+// Clock speed per core (same indices as cpu.core_pct) and temperature sensors
+void sample_sensor_metrics(MemoryStore& store,
+                           int64_t timestamp_ms,
+                           std::vector<double>& freq_buffer,
+                           std::vector<TempReading>& temperatures) {
+    if (get_cpu_frequency_mhz(freq_buffer)) {
+        store.append_vector(selector_for("cpu.freq_mhz", {{"host", cfg::HOST_LABEL}}), timestamp_ms, freq_buffer);
+    }
+
+    if (get_temperatures(temperatures)) {
+        for (const TempReading& reading : temperatures) {
+            store.append(selector_for("sensor.temp", {{"host", cfg::HOST_LABEL}, {"sensor", reading.sensor}}),
+                         timestamp_ms, reading.celsius);
+        }
+    }
 }
 
+// meminfo fields published 1:1 as mem.<name> byte gauges
+struct MemGauge {
+    const char* metric;
+    uint64_t MemDetail::* field;
+};
+
+constexpr MemGauge kMemGauges[] = {
+        {"mem.buffers",     &MemDetail::buffers},
+        {"mem.cached",      &MemDetail::cached},
+        {"mem.shmem",       &MemDetail::shmem},
+        {"mem.dirty",       &MemDetail::dirty},
+        {"mem.writeback",   &MemDetail::writeback},
+        {"mem.anon",        &MemDetail::anon},
+        {"mem.anon_huge",   &MemDetail::anon_huge},
+        {"mem.slab",        &MemDetail::slab},
+        {"mem.slab_reclaimable", &MemDetail::slab_reclaimable},
+        {"mem.swap_cached", &MemDetail::swap_cached},
+};
+
 void sample_memory_metrics(MemoryStore& store, int64_t timestamp_ms) {
-    if (MemBytes bytes; get_system_memory_bytes(bytes)) {
-        const std::string used_selector = selector_for("mem.used", {{"host", cfg::HOST_LABEL}});
-        store.append(used_selector, timestamp_ms, static_cast<double>(bytes.used_bytes));
+    MemDetail detail;
+    if (!get_system_memory_detail(detail)) {
+        return;
+    }
+
+    const uint64_t available = memory_available_bytes(detail);
+    const uint64_t used = detail.total > available ? detail.total - available : 0;
 
-        const std::string free_selector = selector_for("mem.free", {{"host", cfg::HOST_LABEL}});
-        store.append(free_selector, timestamp_ms, static_cast<double>(bytes.free_bytes));
+    const std::string used_selector = selector_for("mem.used", {{"host", cfg::HOST_LABEL}});
+    store.append(used_selector, timestamp_ms, static_cast<double>(used));
+
+    const std::string free_selector = selector_for("mem.free", {{"host", cfg::HOST_LABEL}});
+    store.append(free_selector, timestamp_ms, static_cast<double>(available));
+
+    for (const MemGauge& gauge : kMemGauges) {
+        store.append(selector_for(gauge.metric, {{"host", cfg::HOST_LABEL}}),
+                     timestamp_ms, static_cast<double>(detail.*(gauge.field)));
+    }
+
+    const uint64_t swap_used = detail.swap_total > detail.swap_free ? detail.swap_total - detail.swap_free : 0;
+    store.append(selector_for("mem.swap_used", {{"host", cfg::HOST_LABEL}}),
+                 timestamp_ms, static_cast<double>(swap_used));
+
+    // HugePages_* are page counts; publish them in bytes like everything else
+    const uint64_t huge_used = detail.hugepages_total > detail.hugepages_free
+                               ? detail.hugepages_total - detail.hugepages_free : 0;
+    store.append(selector_for("mem.hugepages_total", {{"host", cfg::HOST_LABEL}}),
+                 timestamp_ms, static_cast<double>(detail.hugepages_total * detail.hugepage_size));
+    store.append(selector_for("mem.hugepages_used", {{"host", cfg::HOST_LABEL}}),
+                 timestamp_ms, static_cast<double>(huge_used * detail.hugepage_size));
+}
+
+// Paging / reclaim / swap event rates for the configured vmstat counters
+void sample_vmstat_metrics(MemoryStore& store, int64_t timestamp_ms, std::vector<VmstatRate>& vmstat_rates) {
+    if (!get_vmstat_rates(vmstat_rates)) {
+        return;
+    }
+
+    for (const VmstatRate& rate : vmstat_rates) {
+        store.append(selector_for("vmstat.rate", {{"host", cfg::HOST_LABEL}, {"counter", rate.key}}),
+                     timestamp_ms, rate.per_s);
+    }
+}
+
+void sample_pressure_metrics(MemoryStore& store, int64_t timestamp_ms, BurstCapture& burst) {
+    PressurePct pressure[kPressureResourceCount];
+    if (!get_pressure_pct(pressure)) {
+        return;
+    }
+
+    for (int resource = 0; resource < kPressureResourceCount; ++resource) {
+        if (!pressure[resource].valid) continue;
+        const char* name = pressure_resource_name(resource);
+        const std::string some_selector = selector_for("psi.some_pct", {
+                {"host", cfg::HOST_LABEL},
+                {"resource", name}
+        });
+        store.append(some_selector, timestamp_ms, pressure[resource].some_pct);
+        burst.observe_psi(name, pressure[resource].some_pct);
+
+        if (pressure[resource].has_full) {
+            const std::string full_selector = selector_for("psi.full_pct", {
+                    {"host", cfg::HOST_LABEL},
+                    {"resource", name}
+            });
+            store.append(full_selector, timestamp_ms, pressure[resource].full_pct);
+        }
     }
 }
 
@@ -70,13 +226,41 @@ void sample_disk_metrics(MemoryStore& store, int64_t timestamp_ms, std::vector<D
     }
 }
 
+void sample_filesystem_metrics(MemoryStore& store, int64_t timestamp_ms, std::vector<FsUsage>& fs_usage) {
+    if (!get_fs_usage(fs_usage)) {
+        return;
+    }
+
+    for (const FsUsage& fs : fs_usage) {
+        auto append = [&](const char* metric, double value) {
+            store.append(selector_for(metric, {{"host", cfg::HOST_LABEL}, {"mount", fs.mount}}), timestamp_ms, value);
+        };
+
+        append("fs.size", static_cast<double>(fs.size_bytes));
+        append("fs.used", static_cast<double>(fs.used_bytes));
+        append("fs.avail", static_cast<double>(fs.avail_bytes));
+        // Same definition as df: used / (used + available to users)
+        const uint64_t usable = fs.used_bytes + fs.avail_bytes;
+        append("fs.used_pct", usable ? 100.0 * static_cast<double>(fs.used_bytes) / static_cast<double>(usable) : 0.0);
+        if (fs.inodes_total > 0) {
+            append("fs.inodes_used", static_cast<double>(fs.inodes_used));
+            append("fs.inodes_free", static_cast<double>(fs.inodes_free));
+        }
+    }
+}
+
 void sample_network_metrics(MemoryStore& store,
                             int64_t timestamp_ms,
-                            std::unordered_map<std::string, InterfaceRates>& interface_rates) {
+                            std::unordered_map<std::string, InterfaceRates>& interface_rates,
+                            BurstCapture& burst) {
     if (!get_net_stats(interface_rates)) {
         return;
     }
 
+    double total_rx = 0.0;
+    for (const auto& [interface, rate] : interface_rates) total_rx += rate.rx_bytes_per_s;
+    burst.observe_net_rx(total_rx);
+
     for (const auto& [interface, rate] : interface_rates) {
         const std::string rx_selector = selector_for("net.rx", {
                 {"host", cfg::HOST_LABEL},
@@ -92,6 +276,128 @@ void sample_network_metrics(MemoryStore& store,
     }
 }
 
+// Container / foreign namespaces get an extra "netns" label on the same metrics.
+void sample_netns_metrics(MemoryStore& store, int64_t timestamp_ms, std::vector<NetnsRates>& netns_rates) {
+    if (!cfg::NET_NAMESPACES || !get_netns_net_stats(netns_rates)) {
+        return;
+    }
+
+    for (const NetnsRates& ns : netns_rates) {
+        for (const auto& [interface, rate] : ns.ifaces) {
+            const std::string rx_selector = selector_for("net.rx", {
+                    {"host", cfg::HOST_LABEL},
+                    {"iface", interface},
+                    {"netns", ns.label}
+            });
+            store.append(rx_selector, timestamp_ms, rate.rx_bytes_per_s);
+
+            const std::string tx_selector = selector_for("net.tx", {
+                    {"host", cfg::HOST_LABEL},
+                    {"iface", interface},
+                    {"netns", ns.label}
+            });
+            store.append(tx_selector, timestamp_ms, rate.tx_bytes_per_s);
+        }
+    }
+}
+
+// Series of a cgroup missing from this many cgroup runs in a row are retired,
+// so container churn does not grow the store without bound
+constexpr unsigned kCgroupRetireAfterRuns = 30;
+
+void sample_cgroup_metrics(MemoryStore& store, int64_t timestamp_ms, std::vector<CgroupStats>& cgroup_stats,
+                           std::unordered_map<std::string, unsigned>& runs_missing) {
+    CgroupLimits limits;
+    const auto config = runtime_config();
+    limits.max_depth = config->cgroup_max_depth;
+    limits.max_cgroups = static_cast<size_t>(config->cgroup_max_series);
+    if (!get_cgroup_stats(limits, cgroup_stats)) {
+        return;
+    }
+
+    for (const CgroupStats& cg : cgroup_stats) {
+        auto append = [&](const char* metric, double value) {
+            store.append(selector_for(metric, {{"host", cfg::HOST_LABEL}, {"cgroup", cg.path}}), timestamp_ms, value);
+        };
+
+        append("cgroup.cpu_pct", cg.cpu_pct);
+        append("cgroup.cpu_throttled_pct", cg.cpu_throttled_pct);
+        if (cg.has_memory) {
+            append("cgroup.mem_current", static_cast<double>(cg.mem_current));
+            append("cgroup.mem_anon", static_cast<double>(cg.mem_anon));
+            append("cgroup.mem_file", static_cast<double>(cg.mem_file));
+        }
+        if (cg.has_io) {
+            append("cgroup.io_read", cg.io_read_bytes_per_s);
+            append("cgroup.io_write", cg.io_write_bytes_per_s);
+        }
+
+        for (int resource = 0; resource < kPressureResourceCount; ++resource) {
+            if (!cg.pressure[resource].valid) continue;
+            const char* name = pressure_resource_name(resource);
+            store.append(selector_for("cgroup.psi_some_pct", {
+                    {"host", cfg::HOST_LABEL},
+                    {"cgroup", cg.path},
+                    {"resource", name}
+            }), timestamp_ms, cg.pressure[resource].some_pct);
+            if (cg.pressure[resource].has_full) {
+                store.append(selector_for("cgroup.psi_full_pct", {
+                        {"host", cfg::HOST_LABEL},
+                        {"cgroup", cg.path},
+                        {"resource", name}
+                }), timestamp_ms, cg.pressure[resource].full_pct);
+            }
+        }
+    }
+
+    for (auto& [path, missing] : runs_missing) missing++;
+    for (const CgroupStats& cg : cgroup_stats) runs_missing[cg.path] = 0;
+    for (auto it = runs_missing.begin(); it != runs_missing.end();) {
+        if (it->second < kCgroupRetireAfterRuns) {
+            ++it;
+            continue;
+        }
+        store.retire_series("cgroup.", "cgroup", it->first);
+        it = runs_missing.erase(it);
+    }
+}
+
+// One scalar series per interrupt line / softirq type with its total rate;
+// with IRQ_PER_CPU, also a vector indexed by CPU (ncpu doubles per sample, so
+// opt-in). The chip/handler text of each IRQ goes to the "irq" metadata bucket.
+void sample_irq_metrics(MemoryStore& store,
+                        int64_t timestamp_ms,
+                        std::vector<IrqRates>& irq_rates,
+                        json& irq_descriptions) {
+    if (get_interrupt_rates(irq_rates)) {
+        bool descriptions_changed = false;
+        for (const IrqRates& irq : irq_rates) {
+            store.append(selector_for("irq.rate", {{"host", cfg::HOST_LABEL}, {"irq", irq.name}}),
+                         timestamp_ms, irq.total);
+            if (cfg::IRQ_PER_CPU) {
+                store.append_vector(selector_for("irq.cpu_rate", {{"host", cfg::HOST_LABEL}, {"irq", irq.name}}),
+                                    timestamp_ms, irq.per_cpu);
+            }
+            if (!irq.desc.empty() && !irq_descriptions.contains(irq.name)) {
+                irq_descriptions[irq.name] = irq.desc;
+                descriptions_changed = true;
+            }
+        }
+        if (descriptions_changed) store.put_metadata("irq", irq_descriptions);
+    }
+
+    if (get_softirq_rates(irq_rates)) {
+        for (const IrqRates& softirq : irq_rates) {
+            store.append(selector_for("softirq.rate", {{"host", cfg::HOST_LABEL}, {"softirq", softirq.name}}),
+                         timestamp_ms, softirq.total);
+            if (cfg::IRQ_PER_CPU) {
+                store.append_vector(selector_for("softirq.cpu_rate", {{"host", cfg::HOST_LABEL}, {"softirq", softirq.name}}),
+                                    timestamp_ms, softirq.per_cpu);
+            }
+        }
+    }
+}
+
 json serialize_process_rows(const std::vector<procmon::ProcRow>& rows) {
     json::array_t table;
     table.reserve(rows.size());
@@ -120,56 +426,167 @@ json serialize_process_rows(const std::vector<procmon::ProcRow>& rows) {
 void sample_process_metrics(MemoryStore& store,
                             procmon::ProcSnapshot& previous_snapshot,
                             procmon::ProcSnapshot& current_snapshot,
-                            bool& have_previous_snapshot) {
+                            bool& have_previous_snapshot,
+                            size_t table_limit) {
     if (!procmon::read_proc_snapshot(current_snapshot)) {
         return;
     }
 
     if (have_previous_snapshot) {
-        const auto rows = procmon::top_by_cpu(previous_snapshot, current_snapshot, kProcessTableLimit);
-        store.put_snapshot("processes", serialize_process_rows(rows));
+        const auto rows = procmon::top_by_cpu(previous_snapshot, current_snapshot, table_limit);
+        store.put_table("processes", serialize_process_rows(rows), "pid");
     }
 
     previous_snapshot = std::move(current_snapshot);
     have_previous_snapshot = true;
 }
+
+// Lanes: cheap /proc reads share one thread; the process scan and the
+// per-container collectors get their own so they never hold up CPU samples;
+// statvfs (which may block on network mounts) runs alone.
+constexpr int kFastLane = 0;
+constexpr int kProcessLane = 1;
+constexpr int kContainerLane = 2;
+constexpr int kFilesystemLane = 3;
+
+void register_collectors(CollectorExecutor& executor, MemoryStore& store, BurstCapture& burst,
+                         const SamplerGovernor& governor) {
+    const int64_t period_ms = int64_t(cfg::SAMPLE_PERIOD_S) * 1000;
+
+    executor.add({"cpu", period_ms, 0, kFastLane,
+                  [&store, &burst, proc_stat = ProcStat(), core_percent_buffer = std::vector<double>(),
+                   mode_matrix_buffer = std::vector<double>(), mode_matrix_cores = size_t(0),
+                   runq_wait_buffer = std::vector<double>()](int64_t ts) mutable {
+                      // One /proc/stat parse per run feeds every cpu and sched.* view
+                      const bool have_stat = read_proc_stat(proc_stat);
+                      if (have_stat) {
+                          sample_cpu_metrics(store, ts, proc_stat, core_percent_buffer, mode_matrix_buffer,
+                                             mode_matrix_cores, burst);
+                      }
+                      sample_scheduler_metrics(store, ts, have_stat ? &proc_stat : nullptr, runq_wait_buffer);
+                      return core_percent_buffer.size();
+                  }});
+    executor.add({"sensors", period_ms, 0, kFastLane,
+                  [&store, freq_buffer = std::vector<double>(), temperatures = std::vector<TempReading>()](int64_t ts) mutable {
+                      sample_sensor_metrics(store, ts, freq_buffer, temperatures);
+                      return freq_buffer.size() + temperatures.size();
+                  }});
+    executor.add({"memory", period_ms, 0, kFastLane,
+                  [&store, &burst, vmstat_rates = std::vector<VmstatRate>()](int64_t ts) mutable {
+                      sample_memory_metrics(store, ts);
+                      sample_vmstat_metrics(store, ts, vmstat_rates);
+                      sample_pressure_metrics(store, ts, burst);
+                      return vmstat_rates.size();
+                  }});
+    executor.add({"disk", period_ms, 0, kFastLane,
+                  [&store, disk_io_buffer = std::vector<DiskIO>()](int64_t ts) mutable {
+                      sample_disk_metrics(store, ts, disk_io_buffer);
+                      return disk_io_buffer.size();
+                  }});
+    executor.add({"network", period_ms, 0, kFastLane,
+                  [&store, &burst, interface_rates = std::unordered_map<std::string, InterfaceRates>()](int64_t ts) mutable {
+                      sample_network_metrics(store, ts, interface_rates, burst);
+                      return interface_rates.size();
+                  }});
+    executor.add({"irq", period_ms, 0, kFastLane,
+                  [&store, irq_rates = std::vector<IrqRates>(), irq_descriptions = json::object()](int64_t ts) mutable {
+                      sample_irq_metrics(store, ts, irq_rates, irq_descriptions);
+                      return irq_rates.size();
+                  }});
+
+    executor.add({"process", period_ms, 0, kProcessLane,
+                  [&store, &governor, previous = procmon::ProcSnapshot{}, current = procmon::ProcSnapshot{},
+                   have_previous = false](int64_t) mutable {
+                      sample_process_metrics(store, previous, current, have_previous,
+                                             governor.process_table_limit(runtime_config()->process_table_limit));
+                      return previous.by_pid.size();
+                  }});
+
+    executor.add({"netns", period_ms, 0, kContainerLane,
+                  [&store, netns_rates = std::vector<NetnsRates>()](int64_t ts) mutable {
+                      sample_netns_metrics(store, ts, netns_rates);
+                      return netns_rates.size();
+                  }});
+    executor.add({"cgroup", period_ms, 0, kContainerLane,
+                  [&store, cgroup_stats = std::vector<CgroupStats>(),
+                   runs_missing = std::unordered_map<std::string, unsigned>()](int64_t ts) mutable {
+                      sample_cgroup_metrics(store, ts, cgroup_stats, runs_missing);
+                      return cgroup_stats.size();
+                  }});
+
+    executor.add({"filesystem", int64_t(cfg::FS_PERIOD_S) * 1000, 0, kFilesystemLane,
+                  [&store, fs_usage = std::vector<FsUsage>()](int64_t ts) mutable {
+                      sample_filesystem_metrics(store, ts, fs_usage);
+                      return fs_usage.size();
+                  }});
+}
+
+// Periods from the config file; tasks it does not mention keep their defaults
+void apply_periods(CollectorExecutor& executor, MemoryStore& store, const RuntimeConfig& config) {
+    for (const std::string& task : executor.task_names()) {
+        executor.set_period(task, config.period_ms(task, 0));
+    }
+    // Cached responses and /metrics must not outlive the fastest samples
+    store.set_tick_period_ms(executor.shortest_period_ms(kFastLane));
+}
+
+// SIGHUP: re-read the config file and apply periods, retention and limits
+// (limits are read by the collectors on their next run).
+void reload_runtime_config(CollectorExecutor& executor, MemoryStore& store) {
+    std::string error;
+    if (load_runtime_config(error)) {
+        const auto config = runtime_config();
+        apply_retention(store, *config);
+        apply_periods(executor, store, *config);
+    }
+    store.put_metadata("config", {
+            {"path", runtime_config()->path},
+            {"reloaded_ms", now_ms()},
+            {"error", error}
+    });
+}
 } // namespace
 
 /**
- * Launch the detached sampler loop.
+ * Launch the sampler: every collector is registered as a task with its own
+ * period and lane on a CollectorExecutor.
  *
  * @param store   Shared MemoryStore receiving metrics.
  * @param running Flag toggled by the caller to stop sampling.
- * @return Joinable std::thread that runs the sampler loop.
+ * @return Joinable std::thread that runs the executor (and joins its lanes).
  */
 std::thread start_sampler(MemoryStore& store, std::atomic<bool>& running) {
     return std::thread([&store, &running]() {
-        std::vector<double> core_percent_buffer;
-        std::vector<DiskIO> disk_io_buffer;
-        std::unordered_map<std::string, InterfaceRates> interface_rates;
-
-        procmon::ProcSnapshot previous_process_snapshot{};
-        procmon::ProcSnapshot current_process_snapshot{};
-        bool have_previous_process_snapshot = false;
-
-        while (running.load(std::memory_order_relaxed)) {
-            const int64_t timestamp_ms = now_ms();
-
-            sample_cpu_metrics(store, timestamp_ms, core_percent_buffer);
-
-            sample_memory_metrics(store, timestamp_ms);
-
-            sample_disk_metrics(store, timestamp_ms, disk_io_buffer);
-
-            sample_network_metrics(store, timestamp_ms, interface_rates);
-
-            sample_process_metrics(store,
-                                   previous_process_snapshot,
-                                   current_process_snapshot,
-                                   have_previous_process_snapshot);
+        BurstConfig burst_config;
+        burst_config.enabled = cfg::BURST_CAPTURE;
+        burst_config.cpu_pct = cfg::BURST_CPU_PCT;
+        burst_config.psi_some_pct = cfg::BURST_PSI_PCT;
+        burst_config.interval_ms = cfg::BURST_INTERVAL_MS;
+        burst_config.window_ms = cfg::BURST_WINDOW_MS;
+        burst_config.cooldown_ms = int64_t(cfg::BURST_COOLDOWN_S) * 1000;
+
+        CollectorExecutor executor;
+        GovernorConfig governor_config;
+        governor_config.budget_pct = cfg::CPU_BUDGET_PCT;
+        SamplerGovernor governor(executor, store, governor_config);
+
+        BurstCapture burst(store, burst_config, &governor);
+        std::thread burst_thread([&burst, &running] { burst.run(running); });
+        register_collectors(executor, store, burst, governor);
+        executor.add({"config", 1000, 0, kFastLane, [&executor, &store](int64_t) {
+            if (take_config_reload_request()) reload_runtime_config(executor, store);
+            return size_t(0);
+        }});
+        apply_periods(executor, store, *runtime_config());
+        SelfTelemetry telemetry(store);
+        executor.run(running, [&store, &telemetry, &governor](const TaskRun& run) {
+            const AppendStats appends = telemetry.record(run);
+            governor.observe(run);
+            // The governor's self.* appends are not part of the next task's cost
+            const AppendStats governor_appends = MemoryStore::take_thread_append_stats();
+            store.commit(appends.appends + governor_appends.appends > 0);
+        });
 
-            std::this_thread::sleep_for(std::chrono::seconds(cfg::SAMPLE_PERIOD_S));
-        }
+        burst_thread.join();
     });
 }
-
@@ -4,82 +4,126 @@
 // Created by Sebastian Ibarra on 10/9/25.
 #include "collector/memory.h"
 
+#include <cstddef>
 #include <cstdint>
-#include <fstream>
-#include <sstream>
-#include <string>
-#include <unordered_map>
+#include <cstring>
+#include <fcntl.h>
+#include <string_view>
+#include <unistd.h>
+
+namespace {
+
+// Compile-time schema: meminfo key -> MemDetail field.
+// Listed in kernel order so the lookup cursor usually hits on the first probe.
+struct MeminfoKey {
+    std::string_view key;
+    uint64_t MemDetail::* field;
+};
+
+constexpr MeminfoKey kMeminfoKeys[] = {
+        {"MemTotal",        &MemDetail::total},
+        {"MemFree",         &MemDetail::free},
+        {"MemAvailable",    &MemDetail::available},
+        {"Buffers",         &MemDetail::buffers},
+        {"Cached",          &MemDetail::cached},
+        {"SwapCached",      &MemDetail::swap_cached},
+        {"SwapTotal",       &MemDetail::swap_total},
+        {"SwapFree",        &MemDetail::swap_free},
+        {"Dirty",           &MemDetail::dirty},
+        {"Writeback",       &MemDetail::writeback},
+        {"AnonPages",       &MemDetail::anon},
+        {"Shmem",           &MemDetail::shmem},
+        {"Slab",            &MemDetail::slab},
+        {"SReclaimable",    &MemDetail::slab_reclaimable},
+        {"SUnreclaim",      &MemDetail::slab_unreclaimable},
+        {"AnonHugePages",   &MemDetail::anon_huge},
+        {"HugePages_Total", &MemDetail::hugepages_total},
+        {"HugePages_Free",  &MemDetail::hugepages_free},
+        {"Hugepagesize",    &MemDetail::hugepage_size},
+};
+constexpr size_t kMeminfoKeyCount = sizeof(kMeminfoKeys) / sizeof(kMeminfoKeys[0]);
+
+// Find 'key' in the table starting at 'cursor' (wrapping). Returns kMeminfoKeyCount if absent.
+size_t find_key(std::string_view key, size_t cursor) {
+    for (size_t probe = 0; probe < kMeminfoKeyCount; ++probe) {
+        const size_t i = (cursor + probe) % kMeminfoKeyCount;
+        if (kMeminfoKeys[i].key == key) return i;
+    }
+    return kMeminfoKeyCount;
+}
+
+} // namespace
 
 /*
-*   Static function that returns true if /proc/meminfo is read successfully
-*   Takes in an unordered map where keys are strings like "MemTotal" and values are 64-bit unsigned integers (bytes)
+*   Reads /proc/meminfo in one read() into a stack buffer and fills only the
+*   fields listed in kMeminfoKeys. Values with a "kB" unit are converted to bytes;
+*   unit-less values (HugePages_*) are kept as counts.
 */
-static bool read_meminfo(std::unordered_map<std::string, uint64_t>& kv) {
+bool get_system_memory_detail(MemDetail& md) {
+    int fd = open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
 
-    // Opens '/proc/meminfo'
-    // Returns false if file couldn't be opened
-    std::ifstream f("/proc/meminfo");
-    if (!f.is_open()) return false;
+    char buf[8192];
+    size_t len = 0;
+    ssize_t n;
+    while (len < sizeof(buf) && (n = read(fd, buf + len, sizeof(buf) - len)) > 0) len += size_t(n);
+    close(fd);
+    if (len == 0) return false;
 
-    // Reads file line by line until end of file
-    std::string line;
-    while (std::getline(f, line)) {
-        // Lines look like: "MemTotal:       16333780 kB"
+    md = MemDetail{};
+    bool have_total = false;
+    size_t cursor = 0;
 
-        // Parses each line into the parts
-        // Key, value, unit
-        // if one is missing then line is malformed
-        std::istringstream iss(line);
-        std::string key, unit;
-        uint64_t val_kb = 0;
-        if (!(iss >> key >> val_kb >> unit)) continue;
+    const char* p = buf;
+    const char* end = buf + len;
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+        if (!eol) eol = end;
 
-        // Removes trailing ':' from key
-        if (!key.empty() && key.back() == ':') key.pop_back();
+        // Lines look like: "MemTotal:       16333780 kB"
+        const char* colon = static_cast<const char*>(std::memchr(p, ':', size_t(eol - p)));
+        if (colon) {
+            const size_t idx = find_key(std::string_view(p, size_t(colon - p)), cursor);
+            if (idx < kMeminfoKeyCount) {
+                const char* q = colon + 1;
+                while (q < eol && *q == ' ') ++q;
+                uint64_t val = 0;
+                while (q < eol && *q >= '0' && *q <= '9') val = val * 10 + uint64_t(*q++ - '0');
+                if (q + 3 <= eol && q[1] == 'k' && q[2] == 'B') val *= 1024ULL;
 
-        // Converts kB to bytes
-        uint64_t val_bytes = val_kb * 1024ULL;
-        kv[key] = val_bytes;
+                md.*(kMeminfoKeys[idx].field) = val;
+                if (kMeminfoKeys[idx].field == &MemDetail::total) have_total = true;
+                if (kMeminfoKeys[idx].field == &MemDetail::available) md.has_available = true;
+                cursor = idx + 1;
+            }
+        }
+        p = eol + 1;
     }
-    return true;
+    return have_total;
 }
 
-// Function that initializes
-bool get_system_memory_bytes(MemBytes& mb) {
-    // Declare and initialize unordered map with memory statistics
-    std::unordered_map<std::string, uint64_t> mi;
-    if (!read_meminfo(mi)) return false;
-
-    // Find "MemTotal" in the map,
-    // If not present return false since it is a required field
-    auto itTotal = mi.find("MemTotal");
-    if (itTotal == mi.end()) return false;
-
-    // Total memory present
-    const uint64_t total = itTotal->second;
-
+uint64_t memory_available_bytes(const MemDetail& md) {
     // Prefer MemAvailable if present (best estimate of readily available memory)
-    auto itAvail = mi.find("MemAvailable");
-    if (itAvail != mi.end()) {
-        const uint64_t avail = itAvail->second;
-        mb.free_bytes = avail;                                      // MemAvailable is free memory
-        mb.used_bytes = (total > avail) ? (total - avail) : 0ULL;   // Used is total - free
-        mb.total_bytes = total;
-        return true;
-    }
+    if (md.has_available) return md.available;
 
     // Fallback if MemAvailable is missing (older kernels):
     // avail ≈ MemFree + Buffers + Cached - Shmem
-    const uint64_t memfree = mi.count("MemFree") ? mi["MemFree"] : 0ULL;
-    const uint64_t buffers = mi.count("Buffers") ? mi["Buffers"] : 0ULL;
-    const uint64_t cached  = mi.count("Cached")  ? mi["Cached"]  : 0ULL;
-    const uint64_t shmem   = mi.count("Shmem")   ? mi["Shmem"]   : 0ULL;
+    uint64_t avail = md.free + md.buffers + md.cached;
+    if (avail > md.shmem) avail -= md.shmem;
+    return avail;
+}
 
-    uint64_t avail = memfree + buffers + cached;
-    if (avail > shmem) avail -= shmem;
+// Function that initializes
+bool get_system_memory_bytes(MemBytes& mb) {
+    MemDetail md;
+    if (!get_system_memory_detail(md)) return false;
+
+    // Total memory present
+    const uint64_t total = md.total;
+    const uint64_t avail = memory_available_bytes(md);
 
-    mb.free_bytes = avail;
-    mb.used_bytes = (total > avail) ? (total - avail) : 0ULL;
+    mb.free_bytes = avail;                                      // MemAvailable is free memory
+    mb.used_bytes = (total > avail) ? (total - avail) : 0ULL;   // Used is total - free
     mb.total_bytes = total;
     return true;
 }
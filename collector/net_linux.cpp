@@ -4,12 +4,14 @@
 
 #include "collector/net.h"
 #include <vector>
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <unordered_map>
 #include <iostream>
 #include <cctype>
+#include "config.h"
 #include "metrics/time.h"
 
 static inline std::string trim(const std::string& s){
@@ -19,7 +21,7 @@ static inline std::string trim(const std::string& s){
     return s.substr(a, b - a);
 }
 
-static bool read_proc_net(NetSnapshot& out){
+bool read_proc_net_dev(NetSnapshot& out){
     std::ifstream f("/proc/net/dev");
     if(!f.is_open()) return false;
 
@@ -67,19 +69,77 @@ static bool read_proc_net(NetSnapshot& out){
 }
 
 
+void compute_link_rates(const LinkTable& prev, const LinkTable& curr, double dt_s,
+                        std::unordered_map<std::string, InterfaceRates>& out){
+    out.clear();
+    if(dt_s <= 0) return;
+
+    const size_t n = std::min(prev.slots.size(), curr.slots.size());
+    for (size_t idx = 0; idx < n; ++idx) {
+        const LinkSlot& c = curr.slots[idx];
+        const LinkSlot& p = prev.slots[idx];
+        if(!c.present || !p.present || c.name != p.name) continue;
+
+        InterfaceRates rates;
+        const double drx = (c.counters.rx_bytes >= p.counters.rx_bytes) ? (double)(c.counters.rx_bytes - p.counters.rx_bytes) : 0;
+        const double dtx = (c.counters.tx_bytes >= p.counters.tx_bytes) ? (double)(c.counters.tx_bytes - p.counters.tx_bytes) : 0;
+        rates.rx_bytes_per_s = drx / dt_s;
+        rates.tx_bytes_per_s = dtx / dt_s;
+
+        out.emplace(c.name, rates);
+    }
+}
+
+bool read_interface_counters(NetSnapshot& out, LinkTable& table){
+    if (!cfg::NET_USE_NETLINK) return read_proc_net_dev(out);
+    if (!read_netlink_links(table)) return false;
+
+    out.clear();
+    for (const LinkSlot& slot : table.slots) {
+        if (slot.present) out[slot.name] = slot.counters;
+    }
+    return true;
+}
+
+static bool get_net_stats_netlink(std::unordered_map<std::string, InterfaceRates>& out){
+    static LinkTable prev;
+    static LinkTable curr;
+    static bool initialized = false;
+    static uint64_t prev_time;
+
+    if(!read_netlink_links(curr)){
+        return false;
+    }
+
+    uint64_t time_now = tick_mono_ms();
+
+    const double dt_s = (initialized && time_now > prev_time)
+                        ? static_cast<double>(time_now - prev_time) / 1000
+                        : 0.0;
+    compute_link_rates(prev, curr, dt_s, out);
+
+    // Swap keeps both tables' allocations (names included) alive for the next dump
+    std::swap(prev, curr);
+    prev_time = time_now;
+    initialized = true;
+    return true;
+}
+
 bool get_net_stats(std::unordered_map<std::string, InterfaceRates>& out){
+    if (cfg::NET_USE_NETLINK) return get_net_stats_netlink(out);
+
     static NetSnapshot prev;
     static bool initialized = false;
     static uint64_t prev_time;
 
     // Current values
     NetSnapshot curr;
-    if(!read_proc_net(curr)){
+    if(!read_proc_net_dev(curr)){
         curr.clear();
         return false;
     }
 
-    uint64_t time_now = now_ms();
+    uint64_t time_now = tick_mono_ms();
 
     if(!initialized){
         prev = std::move(curr);
@@ -0,0 +1,206 @@
+//
+// rtnetlink interface counters.
+//
+// Each read sends one RTM_GETSTATS dump filtered to IFLA_STATS_LINK_64, so the
+// kernel returns only the 64-bit counters per link. Names come from an
+// RTM_GETLINK dump, which is much larger per link and therefore only repeated
+// when a new ifindex appears or periodically. Results land in a LinkTable
+// indexed by ifindex: no text parsing, string splitting, or hash map rebuilds.
+//
+#include "collector/net.h"
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// Receive buffer size; the kernel packs as many link messages as fit.
+constexpr size_t kRecvBufferBytes = 64 * 1024;
+
+// Link names are re-dumped at least this often (in reads) to catch renames.
+constexpr unsigned kNameRefreshDumps = 60;
+
+// Lazily opened NETLINK_ROUTE socket, kept for the lifetime of the process.
+// Dumps on it are serialized with shared_socket_mutex(): two dumps in flight
+// on one socket would interleave their replies.
+int netlink_socket() {
+    static const int fd = open_netlink_socket();   // initialization is thread-safe
+    return fd;
+}
+
+std::mutex& shared_socket_mutex() {
+    static std::mutex m;
+    return m;
+}
+
+bool send_dump_request(int fd, uint16_t type, uint32_t seq) {
+    // ifinfomsg and if_stats_msg both start with a family byte; the stats
+    // request additionally narrows the reply to IFLA_STATS_LINK_64 only.
+    struct {
+        nlmsghdr nh;
+        union {
+            ifinfomsg ifm;
+            if_stats_msg ism;
+        };
+    } req{};
+
+    if (type == RTM_GETSTATS) {
+        req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(if_stats_msg));
+        req.ism.family = AF_UNSPEC;
+        req.ism.filter_mask = IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64);
+    } else {
+        req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(ifinfomsg));
+        req.ifm.ifi_family = AF_UNSPEC;
+    }
+    req.nh.nlmsg_type = type;
+    req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nh.nlmsg_seq = seq;
+
+    sockaddr_nl kernel{};
+    kernel.nl_family = AF_NETLINK;
+
+    ssize_t n;
+    do {
+        n = sendto(fd, &req, req.nh.nlmsg_len, 0, reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel));
+    } while (n < 0 && errno == EINTR);
+    return n == static_cast<ssize_t>(req.nh.nlmsg_len);
+}
+
+LinkSlot& slot_for(LinkTable& table, int ifindex) {
+    const size_t idx = static_cast<size_t>(ifindex);
+    if (idx >= table.slots.size()) table.slots.resize(idx + 1);
+    return table.slots[idx];
+}
+
+// RTM_NEWLINK: record the interface name for its ifindex.
+void store_link_name(const nlmsghdr* nh, LinkTable& table) {
+    const auto* ifm = static_cast<const ifinfomsg*>(NLMSG_DATA(nh));
+    if (ifm->ifi_index <= 0) return;
+
+    int attr_len = static_cast<int>(IFLA_PAYLOAD(nh));
+    for (auto* rta = IFLA_RTA(ifm); RTA_OK(rta, attr_len); rta = RTA_NEXT(rta, attr_len)) {
+        if (rta->rta_type == IFLA_IFNAME) {
+            slot_for(table, ifm->ifi_index).name.assign(static_cast<const char*>(RTA_DATA(rta)));
+            return;
+        }
+    }
+}
+
+// RTM_NEWSTATS: copy IFLA_STATS_LINK_64 into the ifindex slot.
+// Returns false when the slot has no name yet (link created since the last name dump).
+bool store_link_stats(const nlmsghdr* nh, LinkTable& table) {
+    const auto* ism = static_cast<const if_stats_msg*>(NLMSG_DATA(nh));
+    if (ism->ifindex == 0) return true;
+
+    const auto* rta = reinterpret_cast<const rtattr*>(
+            reinterpret_cast<const char*>(ism) + NLMSG_ALIGN(sizeof(if_stats_msg)));
+    int attr_len = static_cast<int>(nh->nlmsg_len) - static_cast<int>(NLMSG_LENGTH(sizeof(if_stats_msg)));
+    for (; RTA_OK(rta, attr_len); rta = RTA_NEXT(rta, attr_len)) {
+        if (rta->rta_type != IFLA_STATS_LINK_64 || RTA_PAYLOAD(rta) < sizeof(rtnl_link_stats64)) continue;
+
+        LinkSlot& slot = slot_for(table, static_cast<int>(ism->ifindex));
+        slot.present = true;
+
+        // rtnl_link_stats64 may be unaligned inside the attribute; copy it out first
+        rtnl_link_stats64 s;
+        std::memcpy(&s, RTA_DATA(rta), sizeof(s));
+        slot.counters.rx_bytes = s.rx_bytes;
+        slot.counters.rx_packets = s.rx_packets;
+        slot.counters.rx_errs = s.rx_errors;
+        slot.counters.rx_drop = s.rx_dropped;
+        slot.counters.tx_bytes = s.tx_bytes;
+        slot.counters.tx_packets = s.tx_packets;
+        slot.counters.tx_errs = s.tx_errors;
+        slot.counters.tx_drop = s.tx_dropped;
+        return !slot.name.empty();
+    }
+    return true;
+}
+
+// Run one dump of 'type' and feed every reply message to 'on_msg'. The
+// receive buffer and sequence counter are per thread, so lanes reading
+// different sockets (network, netns) never share them.
+template<typename OnMsg>
+bool run_dump(int fd, uint16_t type, OnMsg&& on_msg) {
+    thread_local std::vector<char> buf(kRecvBufferBytes);
+    thread_local uint32_t seq = 0;
+
+    const uint32_t my_seq = ++seq;
+    if (!send_dump_request(fd, type, my_seq)) return false;
+
+    while (true) {
+        ssize_t n = recv(fd, buf.data(), buf.size(), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) return false;
+
+        int len = static_cast<int>(n);
+        for (auto* nh = reinterpret_cast<nlmsghdr*>(buf.data()); NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+            if (nh->nlmsg_seq != my_seq) continue;  // stale reply from an aborted dump
+            if (nh->nlmsg_type == NLMSG_DONE) return true;
+            if (nh->nlmsg_type == NLMSG_ERROR) return false;
+            on_msg(nh);
+        }
+    }
+}
+
+} // namespace
+
+int open_netlink_socket() {
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) return -1;
+
+    sockaddr_nl local{};
+    local.nl_family = AF_NETLINK;
+    if (bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool read_netlink_links(LinkTable& table, int fd) {
+    std::unique_lock<std::mutex> shared_lk;
+    if (fd < 0) {
+        fd = netlink_socket();
+        shared_lk = std::unique_lock<std::mutex>(shared_socket_mutex());
+    }
+    if (fd < 0) return false;
+
+    for (auto& slot : table.slots) slot.present = false;
+
+    bool names_complete = true;
+    const bool stats_ok = run_dump(fd, RTM_GETSTATS, [&](const nlmsghdr* nh) {
+        if (nh->nlmsg_type == RTM_NEWSTATS && !store_link_stats(nh, table)) names_complete = false;
+    });
+    if (!stats_ok) return false;
+
+    // Names are refreshed when an unnamed ifindex shows up and every
+    // kNameRefreshDumps reads, so renames and ifindex reuse are picked up too.
+    if (!names_complete || table.reads_since_names >= kNameRefreshDumps) {
+        for (auto& slot : table.slots) slot.name.clear();
+        const bool names_ok = run_dump(fd, RTM_GETLINK, [&](const nlmsghdr* nh) {
+            if (nh->nlmsg_type == RTM_NEWLINK) store_link_name(nh, table);
+        });
+        if (!names_ok) return false;
+        table.reads_since_names = 0;
+    } else {
+        ++table.reads_since_names;
+    }
+
+    // Loopback and links that vanished between the two dumps are not reported
+    for (auto& slot : table.slots) {
+        if (slot.present && (slot.name.empty() || slot.name == "lo")) slot.present = false;
+    }
+    return true;
+}
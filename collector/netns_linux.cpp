@@ -0,0 +1,229 @@
+//
+// netns_linux.cpp — per-namespace interface rates for containers.
+//
+// Namespaces are found by scanning /proc/[pid]/ns/net and keyed by inode, so
+// hundreds of processes sharing one container namespace cost a single entry.
+// For each new namespace a helper thread setns()'s into it, opens a netlink
+// socket (which stays bound to that namespace), and switches back. Every tick
+// is then just one RTM_GETSTATS dump per cached socket.
+//
+#include "collector/netns.h"
+
+#include <cctype>
+#include <condition_variable>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <sched.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "metrics/time.h"
+
+namespace {
+
+// Namespaces are rediscovered every this many collections.
+constexpr unsigned kDiscoveryEveryTicks = 10;
+
+struct NsEntry {
+    int ns_fd = -1;     // open /proc/[pid]/ns/net, keeps the identity pinned
+    int nl_fd = -1;     // netlink socket created inside the namespace (-1 if setns failed)
+    std::string label;
+    LinkTable prev;
+    LinkTable curr;
+    uint64_t prev_time = 0;
+    bool have_prev = false;
+
+    NsEntry() = default;
+    NsEntry(const NsEntry&) = delete;
+    NsEntry& operator=(const NsEntry&) = delete;
+
+    ~NsEntry() {
+        if (nl_fd >= 0) close(nl_fd);
+        if (ns_fd >= 0) close(ns_fd);
+    }
+};
+
+// Container ids are 64 hex chars somewhere in the cgroup path
+// (docker-<id>.scope, /docker/<id>, cri-containerd-<id>.scope, libpod-<id> ...).
+std::string container_id_for_pid(const std::string& pid) {
+    std::ifstream f("/proc/" + pid + "/cgroup");
+    std::string line;
+    while (std::getline(f, line)) {
+        size_t run = 0;
+        for (size_t i = 0; i < line.size(); ++i) {
+            if (std::isxdigit(static_cast<unsigned char>(line[i]))) {
+                if (++run == 64) return line.substr(i + 1 - 64, 12);
+            } else {
+                run = 0;
+            }
+        }
+    }
+    return {};
+}
+
+ino_t ns_inode(const std::string& path) {
+    struct stat st{};
+    return stat(path.c_str(), &st) == 0 ? st.st_ino : 0;
+}
+
+class NetnsCollector {
+public:
+    NetnsCollector() {
+        self_fd_ = open("/proc/thread-self/ns/net", O_RDONLY | O_CLOEXEC);
+        self_ino_ = ns_inode("/proc/self/ns/net");
+    }
+
+    // False once the thread could not get back to its own namespace
+    bool collect(std::vector<NetnsRates>& out) {
+        out.clear();
+        if (stranded_) return false;
+        if (ticks_++ % kDiscoveryEveryTicks == 0) discover();
+        if (stranded_) return false;
+
+        out.reserve(entries_.size());
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            NsEntry& e = it->second;
+            if (e.nl_fd < 0) {
+                ++it;
+                continue;
+            }
+            // Usually the namespace is gone: release its pin (and veths) now
+            // rather than at the next discovery
+            if (!read_netlink_links(e.curr, e.nl_fd)) {
+                it = entries_.erase(it);
+                continue;
+            }
+
+            const uint64_t time_now = tick_mono_ms();
+            const double dt_s = (e.have_prev && time_now > e.prev_time)
+                                ? static_cast<double>(time_now - e.prev_time) / 1000
+                                : 0.0;
+
+            NetnsRates rates;
+            rates.label = e.label;
+            compute_link_rates(e.prev, e.curr, dt_s, rates.ifaces);
+            if (!rates.ifaces.empty()) out.push_back(std::move(rates));
+
+            std::swap(e.prev, e.curr);
+            e.prev_time = time_now;
+            e.have_prev = true;
+            ++it;
+        }
+        return true;
+    }
+
+private:
+    void discover() {
+        DIR* d = opendir("/proc");
+        if (!d) return;
+
+        std::unordered_set<ino_t> seen;
+        while (dirent* de = readdir(d)) {
+            if (!std::isdigit(static_cast<unsigned char>(de->d_name[0]))) continue;
+
+            const std::string pid = de->d_name;
+            const std::string path = "/proc/" + pid + "/ns/net";
+            const ino_t ino = ns_inode(path);
+            if (ino == 0 || ino == self_ino_) continue;
+            if (!seen.insert(ino).second) continue;
+            if (const auto it = entries_.find(ino); it != entries_.end()) {
+                // Known namespace; retry the socket if setns failed last time
+                if (it->second.nl_fd < 0) it->second.nl_fd = open_socket_in(it->second.ns_fd);
+                if (stranded_) break;
+                continue;
+            }
+
+            // New namespace: pin it and open a socket inside it
+            const int ns_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (ns_fd < 0) continue;
+
+            NsEntry& e = entries_[ino];
+            e.ns_fd = ns_fd;
+            e.label = container_id_for_pid(pid);
+            if (e.label.empty()) e.label = "ns-" + std::to_string(ino);
+            e.nl_fd = open_socket_in(ns_fd);
+            if (stranded_) break;
+        }
+        closedir(d);
+
+        // Every later socket would land in the wrong namespace: give up
+        if (stranded_) {
+            entries_.clear();
+            return;
+        }
+
+        // Drop namespaces whose last process is gone
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            it = seen.count(it->first) ? std::next(it) : entries_.erase(it);
+        }
+    }
+
+    int open_socket_in(int ns_fd) {
+        if (self_fd_ < 0) return -1;
+        if (setns(ns_fd, CLONE_NEWNET) != 0) return -1;
+        const int fd = open_netlink_socket();
+        if (setns(self_fd_, CLONE_NEWNET) != 0) {
+            if (fd >= 0) close(fd);
+            stranded_ = true;
+            return -1;
+        }
+        return fd;
+    }
+
+    int self_fd_ = -1;
+    bool stranded_ = false;     // stuck in a foreign namespace; collection stopped
+    ino_t self_ino_ = 0;
+    unsigned ticks_ = 0;
+    std::unordered_map<ino_t, NsEntry> entries_;
+};
+
+// Requests are handed to one long-lived helper thread so that setns never
+// touches the sampler thread's namespace.
+struct HelperThread {
+    std::mutex m;
+    std::condition_variable cv;
+    std::vector<NetnsRates>* request = nullptr;
+    int64_t tick = 0;       // caller's tick, so rates share its time base
+    bool done = false;
+    bool ok = true;
+
+    HelperThread() {
+        std::thread([this] {
+            NetnsCollector collector;
+            std::unique_lock<std::mutex> lk(m);
+            while (true) {
+                cv.wait(lk, [this] { return request != nullptr; });
+                set_tick_mono_ms(tick);
+                ok = collector.collect(*request);
+                request = nullptr;
+                done = true;
+                cv.notify_all();
+            }
+        }).detach();
+    }
+};
+
+} // namespace
+
+bool get_netns_net_stats(std::vector<NetnsRates>& out) {
+    // Intentionally leaked: the detached helper may still be waiting on the
+    // condition variable during static destruction.
+    static HelperThread* helper = new HelperThread();
+
+    std::unique_lock<std::mutex> lk(helper->m);
+    helper->request = &out;
+    helper->tick = tick_mono_ms();
+    helper->done = false;
+    helper->cv.notify_all();
+    helper->cv.wait(lk, [] { return helper->done; });
+    return helper->ok;
+}
@@ -0,0 +1,101 @@
+//
+// pressure_linux.cpp — stall percentages from /proc/pressure/{cpu,memory,io}.
+//
+// Each file looks like:
+//   some avg10=0.00 avg60=0.00 avg300=0.00 total=131323215
+//   full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+// The kernel's avg10 is a 10 s decaying average; deltas of "total" (µs stalled)
+// give the exact stall share over our own sample interval instead.
+//
+#include "collector/pressure.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "metrics/time.h"
+
+namespace {
+
+constexpr const char* kPressurePaths[kPressureResourceCount] = {
+        "/proc/pressure/cpu", "/proc/pressure/memory", "/proc/pressure/io"
+};
+
+} // namespace
+
+// Parse "total=" of the some/full lines.
+bool parse_pressure_totals(const char* buf, size_t len, PressureTotals& t) {
+    bool have_some = false;
+    const char* p = buf;
+    const char* end = buf + len;
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+        if (!eol) eol = end;
+
+        const char* tot = nullptr;
+        for (const char* q = p; q + 6 <= eol; ++q) {
+            if (std::memcmp(q, "total=", 6) == 0) { tot = q + 6; break; }
+        }
+        if (tot) {
+            uint64_t v = 0;
+            while (tot < eol && *tot >= '0' && *tot <= '9') v = v * 10 + uint64_t(*tot++ - '0');
+            if (std::memcmp(p, "some", 4) == 0) { t.some_us = v; have_some = true; }
+            else if (std::memcmp(p, "full", 4) == 0) { t.full_us = v; t.has_full = true; }
+        }
+        p = eol + 1;
+    }
+    return have_some;
+}
+
+PressurePct pressure_pct_between(const PressureTotals& prev, const PressureTotals& cur, double dt_us) {
+    PressurePct out;
+    out.has_full = cur.has_full;
+    if (dt_us <= 0) return out;
+
+    const uint64_t dsome = cur.some_us >= prev.some_us ? cur.some_us - prev.some_us : 0;
+    const uint64_t dfull = cur.full_us >= prev.full_us ? cur.full_us - prev.full_us : 0;
+    out.some_pct = std::min(100.0, 100.0 * double(dsome) / dt_us);
+    out.full_pct = std::min(100.0, 100.0 * double(dfull) / dt_us);
+    out.valid = true;
+    return out;
+}
+
+const char* pressure_resource_name(int resource) {
+    static constexpr const char* kNames[kPressureResourceCount] = {"cpu", "memory", "io"};
+    return (resource >= 0 && resource < kPressureResourceCount) ? kNames[resource] : "unknown";
+}
+
+bool get_pressure_pct(PressurePct (&out)[kPressureResourceCount]) {
+    // Files stay open; PSI supports re-reading from offset 0 with pread
+    static int fds[kPressureResourceCount] = {-2, -2, -2};
+    static PressureTotals prev[kPressureResourceCount];
+    static bool have_prev[kPressureResourceCount] = {};
+    static uint64_t prev_time;
+
+    const uint64_t time_now = tick_mono_ms();
+    const double dt_us = time_now > prev_time ? double(time_now - prev_time) * 1000.0 : 0.0;
+
+    bool any = false;
+    for (int r = 0; r < kPressureResourceCount; ++r) {
+        out[r] = PressurePct{};
+        if (fds[r] == -2) fds[r] = open(kPressurePaths[r], O_RDONLY | O_CLOEXEC);
+        if (fds[r] < 0) continue;
+
+        char buf[256];
+        const ssize_t n = pread(fds[r], buf, sizeof(buf), 0);
+        PressureTotals cur;
+        if (n <= 0 || !parse_pressure_totals(buf, size_t(n), cur)) {
+            have_prev[r] = false;
+            continue;
+        }
+        any = true;
+
+        out[r] = pressure_pct_between(prev[r], cur, have_prev[r] ? dt_us : 0.0);
+        prev[r] = cur;
+        have_prev[r] = true;
+    }
+
+    prev_time = time_now;
+    return any;
+}
@@ -0,0 +1,185 @@
+//
+// sensors_linux.cpp — cpufreq and temperature collector.
+//
+// The sysfs files are found once, on first use, and kept open; every tick is
+// then one pread(…, 0) per file back to back with no path lookups. Hosts
+// without cpufreq / hwmon / thermal (most VMs and containers) end up with
+// empty file sets and the getters return false without touching sysfs again,
+// except for the online cpu mask, which is re-read so the cpufreq files are
+// reopened after a hotplug.
+//
+#include "collector/sensors.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace {
+
+struct SensorFile {
+    std::string sensor;
+    int fd = -1;
+};
+
+// Read a small sysfs text file from the start; empty on error.
+std::string pread_text(int fd) {
+    char buf[256];
+    const ssize_t n = fd >= 0 ? pread(fd, buf, sizeof(buf), 0) : -1;
+    return n > 0 ? std::string(buf, static_cast<size_t>(n)) : std::string();
+}
+
+// Read a small sysfs integer file; false on error or empty read.
+bool pread_int(int fd, long long& value) {
+    char buf[32];
+    const ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) return false;
+    buf[n] = '\0';
+    char* end = nullptr;
+    value = std::strtoll(buf, &end, 10);
+    return end != buf;
+}
+
+std::string read_line(const std::string& path) {
+    std::ifstream f(path);
+    std::string line;
+    std::getline(f, line);
+    return line;
+}
+
+// Parse a cpu list such as "0-3,8,10-11".
+std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) comma = list.size();
+        const std::string range = list.substr(pos, comma - pos);
+        const size_t dash = range.find('-');
+        if (!range.empty()) {
+            const int first = std::atoi(range.c_str());
+            const int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        }
+        pos = comma + 1;
+    }
+    return cpus;
+}
+
+// Sorted entries of 'dir' starting with 'prefix'
+std::vector<std::string> list_dir(const std::string& dir, const std::string& prefix) {
+    std::vector<std::string> names;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return names;
+    while (dirent* de = readdir(d)) {
+        const std::string name = de->d_name;
+        if (name.compare(0, prefix.size(), prefix) == 0) names.push_back(name);
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+// scaling_cur_freq of every cpu in 'online', for as long as the mask holds
+struct CpufreqFiles {
+    int online_fd = open("/sys/devices/system/cpu/online", O_RDONLY | O_CLOEXEC);
+    std::string online;
+    std::vector<int> fds;
+    bool opened = false;
+
+    // Reopen the per-cpu files when the online mask changed (cpu hotplug),
+    // so indices keep following the cpuN lines of /proc/stat.
+    void refresh() {
+        if (opened && online_fd < 0) return;    // no mask to watch: keep the first set
+        std::string mask = pread_text(online_fd);
+        if (opened && mask == online) return;
+        opened = true;
+        online = std::move(mask);
+
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+        fds.clear();
+        for (int cpu : parse_cpu_list(online)) {
+            const std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/scaling_cur_freq";
+            fds.push_back(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+        }
+        // No cpufreq driver at all: report nothing rather than a row of zeros
+        if (std::all_of(fds.begin(), fds.end(), [](int fd) { return fd < 0; })) fds.clear();
+    }
+};
+
+std::vector<SensorFile> open_temperature_files() {
+    std::vector<SensorFile> files;
+    std::unordered_set<std::string> names;
+
+    const std::string hwmon_root = "/sys/class/hwmon/";
+    for (const std::string& hwmon : list_dir(hwmon_root, "hwmon")) {
+        const std::string dir = hwmon_root + hwmon + "/";
+        std::string chip = read_line(dir + "name");
+        if (chip.empty()) chip = hwmon;
+
+        for (const std::string& entry : list_dir(dir, "temp")) {
+            const size_t suffix = entry.rfind("_input");
+            if (suffix == std::string::npos || suffix + 6 != entry.size()) continue;
+
+            std::string label = read_line(dir + entry.substr(0, suffix) + "_label");
+            if (label.empty()) label = entry.substr(0, suffix);
+
+            // Multi-socket boxes have one "coretemp" chip per package with the same labels
+            std::string sensor = chip + "/" + label;
+            if (!names.insert(sensor).second) sensor = chip + "/" + hwmon + "/" + label;
+
+            SensorFile f{sensor, open((dir + entry).c_str(), O_RDONLY | O_CLOEXEC)};
+            if (f.fd >= 0) files.push_back(std::move(f));
+        }
+    }
+
+    const std::string thermal_root = "/sys/class/thermal/";
+    for (const std::string& zone : list_dir(thermal_root, "thermal_zone")) {
+        const std::string dir = thermal_root + zone + "/";
+        std::string type = read_line(dir + "type");
+        if (type.empty()) type = zone;
+
+        std::string sensor = "thermal/" + type;
+        if (!names.insert(sensor).second) sensor = "thermal/" + zone;
+
+        SensorFile f{sensor, open((dir + "temp").c_str(), O_RDONLY | O_CLOEXEC)};
+        if (f.fd >= 0) files.push_back(std::move(f));
+    }
+    return files;
+}
+
+} // namespace
+
+bool get_cpu_frequency_mhz(std::vector<double>& out_mhz) {
+    static CpufreqFiles files;
+    files.refresh();
+    const std::vector<int>& fds = files.fds;
+    if (fds.empty()) return false;
+
+    out_mhz.assign(fds.size(), 0.0);
+    for (size_t i = 0; i < fds.size(); ++i) {
+        long long khz = 0;
+        if (fds[i] >= 0 && pread_int(fds[i], khz)) out_mhz[i] = double(khz) / 1000.0;
+    }
+    return true;
+}
+
+bool get_temperatures(std::vector<TempReading>& out) {
+    static const std::vector<SensorFile> files = open_temperature_files();
+    if (files.empty()) return false;
+
+    out.clear();
+    for (const SensorFile& f : files) {
+        long long millideg = 0;
+        if (!pread_int(f.fd, millideg)) continue;  // sensor asleep / not supported
+        out.push_back(TempReading{f.sensor, double(millideg) / 1000.0});
+    }
+    return true;
+}
@@ -0,0 +1,165 @@
+//
+// telemetry.cpp — SelfTelemetry bookkeeping and the /api/status summary.
+//
+// Selectors are built once per task, and the histogram is a fixed array of
+// counters, so recording a run costs a few appends and no allocation beyond
+// the histogram sample itself.
+//
+#include "collector/telemetry.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "config.h"
+#include "metrics/metric_key.h"
+#include "metrics/time.h"
+
+namespace {
+
+using json = nlohmann::json;
+
+constexpr int64_t kSummaryEveryMs = 1000;
+constexpr size_t kBucketCount = kTaskDurationBucketsMs.size() + 1;
+
+size_t bucket_for(double duration_ms) {
+    const auto it = std::lower_bound(kTaskDurationBucketsMs.begin(), kTaskDurationBucketsMs.end(), duration_ms);
+    return size_t(it - kTaskDurationBucketsMs.begin());
+}
+
+std::string task_selector(const char* metric, const std::string& task) {
+    return metric_with_labels(metric, {{"host", cfg::HOST_LABEL}, {"task", task}});
+}
+
+} // namespace
+
+struct SelfTelemetry::TaskStats {
+    explicit TaskStats(const std::string& task)
+            : duration(task_selector("self.task_duration_ms", task)),
+              histogram(task_selector("self.task_duration_hist", task)),
+              jitter(task_selector("self.tick_jitter_ms", task)),
+              lateness(task_selector("self.lateness_ms", task)),
+              items(task_selector("self.items", task)),
+              appends(task_selector("self.store_appends", task)),
+              append_us(task_selector("self.store_append_us", task)),
+              missed(task_selector("self.missed_ticks", task)),
+              deadline_misses(task_selector("self.deadline_misses", task)) {}
+
+    // Upper bound (ms) of the bucket holding quantile q; the open bucket
+    // reports the largest duration seen.
+    double quantile_ms(double q) const {
+        const double rank = q * double(runs);
+        uint64_t seen = 0;
+        for (size_t b = 0; b < kTaskDurationBucketsMs.size(); ++b) {
+            seen += buckets[b];
+            if (double(seen) >= rank) return kTaskDurationBucketsMs[b];
+        }
+        return max_duration_ms;
+    }
+
+    const std::string duration, histogram, jitter, lateness, items, appends, append_us, missed, deadline_misses;
+
+    std::array<uint64_t, kBucketCount> buckets{};
+    uint64_t runs = 0;
+    uint64_t late_runs = 0;
+    uint64_t missed_ticks = 0;
+    double total_duration_ms = 0.0;
+    double last_duration_ms = 0.0;
+    double max_duration_ms = 0.0;
+    double last_jitter_ms = 0.0;
+    double max_jitter_ms = 0.0;
+    double max_lateness_ms = 0.0;
+    size_t last_items = 0;
+    AppendStats last_appends;
+};
+
+SelfTelemetry::SelfTelemetry(MemoryStore& store) : store_(store) {}
+
+SelfTelemetry::~SelfTelemetry() = default;
+
+SelfTelemetry::TaskStats& SelfTelemetry::stats_for(const std::string& task) {
+    auto& slot = tasks_[task];
+    if (!slot) slot = std::make_unique<TaskStats>(task);
+    return *slot;
+}
+
+AppendStats SelfTelemetry::record(const TaskRun& run) {
+    const AppendStats appends = MemoryStore::take_thread_append_stats();
+    const int64_t ts = run.timestamp_ms;
+    const double duration_ms = double(run.duration_us) / 1000.0;
+    const double jitter_ms = double(run.start_lag_us) / 1000.0;
+    const double lateness_ms = double(run.lateness_us) / 1000.0;
+
+    TaskStats* stats = nullptr;
+    std::vector<double> histogram;
+    {
+        std::scoped_lock lk(m_);
+        stats = &stats_for(run.task->name);
+        stats->buckets[bucket_for(duration_ms)]++;
+        stats->runs++;
+        stats->late_runs += run.late ? 1 : 0;
+        stats->missed_ticks += uint64_t(run.missed);
+        stats->total_duration_ms += duration_ms;
+        stats->last_duration_ms = duration_ms;
+        stats->max_duration_ms = std::max(stats->max_duration_ms, duration_ms);
+        stats->last_jitter_ms = jitter_ms;
+        stats->max_jitter_ms = std::max(stats->max_jitter_ms, jitter_ms);
+        stats->max_lateness_ms = std::max(stats->max_lateness_ms, lateness_ms);
+        stats->last_items = run.items;
+        stats->last_appends = appends;
+        histogram.assign(stats->buckets.begin(), stats->buckets.end());
+
+        const int64_t mono_now = mono_ms();
+        if (mono_now - last_summary_ms_ >= kSummaryEveryMs) {
+            last_summary_ms_ = mono_now;
+            publish_summary();
+        }
+    }
+
+    // Selectors are immutable once created, so the appends need no lock
+    store_.append(stats->duration, ts, duration_ms);
+    store_.append_vector(stats->histogram, ts, std::move(histogram));
+    store_.append(stats->jitter, ts, jitter_ms);
+    store_.append(stats->lateness, ts, lateness_ms);
+    store_.append(stats->items, ts, double(run.items));
+    store_.append(stats->appends, ts, double(appends.appends));
+    store_.append(stats->append_us, ts, double(appends.elapsed_ns) / 1000.0);
+    store_.append(stats->missed, ts, double(run.missed));
+    store_.append(stats->deadline_misses, ts, run.late ? 1.0 : 0.0);
+
+    // Our own appends are not part of the next task's cost
+    MemoryStore::take_thread_append_stats();
+    return appends;
+}
+
+// Caller holds m_.
+void SelfTelemetry::publish_summary() {
+    json tasks = json::object();
+    double busy_ms = 0.0;
+    for (const auto& [name, s] : tasks_) {
+        busy_ms += s->total_duration_ms;
+        tasks[name] = {
+                {"runs", s->runs},
+                {"duration_ms", {
+                        {"last", s->last_duration_ms},
+                        {"avg", s->runs ? s->total_duration_ms / double(s->runs) : 0.0},
+                        {"p50", s->quantile_ms(0.50)},
+                        {"p95", s->quantile_ms(0.95)},
+                        {"p99", s->quantile_ms(0.99)},
+                        {"max", s->max_duration_ms}
+                }},
+                {"jitter_ms", {{"last", s->last_jitter_ms}, {"max", s->max_jitter_ms}}},
+                {"max_lateness_ms", s->max_lateness_ms},
+                {"late_runs", s->late_runs},
+                {"missed_ticks", s->missed_ticks},
+                {"items", s->last_items},
+                {"store_appends", s->last_appends.appends},
+                {"store_append_us", double(s->last_appends.elapsed_ns) / 1000.0}
+        };
+    }
+    store_.put_snapshot("self", {
+            {"updated_ms", now_ms()},
+            {"busy_ms", busy_ms},
+            {"duration_buckets_ms", kTaskDurationBucketsMs},
+            {"tasks", std::move(tasks)}
+    });
+}
@@ -0,0 +1,138 @@
+//
+// vmstat_linux.cpp — /proc/vmstat counter deltas.
+//
+// /proc/vmstat is ~200 "name value" lines whose order is fixed for the life of
+// the kernel. The wanted names are looked up once and remembered as line
+// numbers; each tick then only counts newlines and parses the digits on the
+// remembered lines. A change in the total line count triggers a new lookup.
+//
+#include "collector/vmstat.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string_view>
+#include <unistd.h>
+#include <utility>
+
+#include "config.h"
+#include "metrics/time.h"
+
+namespace {
+
+struct Slot {
+    size_t line;          // 0-based line in /proc/vmstat
+    size_t key_index;     // position in the caller's key list
+    uint64_t prev = 0;
+};
+
+// The key list is fixed at construction, so a tick never compares it.
+class VmstatReader {
+public:
+    explicit VmstatReader(std::vector<std::string> keys) : keys_(std::move(keys)) {}
+
+    bool collect(std::vector<VmstatRate>& out) {
+        if (fd_ < 0) fd_ = open("/proc/vmstat", O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) return false;
+
+        const size_t len = read_all();
+        if (len == 0) return false;
+
+        out.clear();
+        if (count_lines(len) != line_count_) {
+            resolve(len);
+            return true;
+        }
+
+        const uint64_t time_now = tick_mono_ms();
+        const double dt_s = time_now > prev_time_ ? double(time_now - prev_time_) / 1000.0 : 0.0;
+
+        // Slots are sorted by line, so one forward pass visits them all
+        const char* p = buf_.data();
+        const char* end = p + len;
+        size_t line = 0;
+        for (Slot& slot : slots_) {
+            for (; line < slot.line && p < end; ++line) {
+                p = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+                if (!p) return false;
+                ++p;
+            }
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+            if (!eol) eol = end;
+            const char* sp = static_cast<const char*>(std::memchr(p, ' ', size_t(eol - p)));
+            if (!sp) continue;
+
+            const uint64_t value = parse_u64(sp + 1, eol);
+            if (dt_s > 0.0) {
+                out.push_back(VmstatRate{keys_[slot.key_index],
+                                         value >= slot.prev ? double(value - slot.prev) / dt_s : 0.0});
+            }
+            slot.prev = value;
+        }
+        prev_time_ = time_now;
+        return true;
+    }
+
+private:
+    static uint64_t parse_u64(const char* p, const char* end) {
+        uint64_t v = 0;
+        while (p < end && *p >= '0' && *p <= '9') v = v * 10 + uint64_t(*p++ - '0');
+        return v;
+    }
+
+    size_t read_all() {
+        if (buf_.empty()) buf_.resize(16 * 1024);
+        size_t len = 0;
+        while (true) {
+            if (len == buf_.size()) buf_.resize(buf_.size() * 2);
+            const ssize_t n = pread(fd_, buf_.data() + len, buf_.size() - len, off_t(len));
+            if (n <= 0) break;
+            len += size_t(n);
+        }
+        return len;
+    }
+
+    size_t count_lines(size_t len) const {
+        return size_t(std::count(buf_.data(), buf_.data() + len, '\n'));
+    }
+
+    // Map every wanted key to its line and take the current values as baselines.
+    void resolve(size_t len) {
+        slots_.clear();
+        line_count_ = count_lines(len);
+
+        const char* p = buf_.data();
+        const char* end = p + len;
+        for (size_t line = 0; p < end; ++line) {
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+            if (!eol) eol = end;
+            const char* sp = static_cast<const char*>(std::memchr(p, ' ', size_t(eol - p)));
+            if (sp) {
+                const std::string_view name(p, size_t(sp - p));
+                for (size_t k = 0; k < keys_.size(); ++k) {
+                    if (keys_[k] == name) {
+                        slots_.push_back(Slot{line, k, parse_u64(sp + 1, eol)});
+                        break;
+                    }
+                }
+            }
+            p = eol + 1;
+        }
+        prev_time_ = tick_mono_ms();
+    }
+
+    const std::vector<std::string> keys_;
+    int fd_ = -1;
+    std::vector<char> buf_;
+    std::vector<Slot> slots_;
+    size_t line_count_ = 0;
+    uint64_t prev_time_ = 0;
+};
+
+} // namespace
+
+bool get_vmstat_rates(std::vector<VmstatRate>& out) {
+    static VmstatReader reader(cfg::VMSTAT_KEYS);
+    return reader.collect(out);
+}
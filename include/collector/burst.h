@@ -0,0 +1,75 @@
+//
+// burst.h — triggered high-frequency capture of CPU, network and processes.
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_BURST_H
+#define SYSTEM_MONITORING_DASHBOARD_BURST_H
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "store/memory_store.h"
+
+class SamplerGovernor;
+
+struct BurstConfig {
+    bool enabled = true;
+    double cpu_pct = 90.0;              // cpu.total_pct at or above
+    double psi_some_pct = 10.0;         // any psi.some_pct at or above
+    double net_rx_spike = 4.0;          // total rx this many times its moving average ...
+    double net_rx_floor = 1e6;          // ... and at least this many bytes/sec
+    int64_t interval_ms = 50;
+    int64_t window_ms = 5000;
+    int64_t cooldown_ms = 60000;        // quiet time after a capture before re-arming
+    int process_every = 4;              // process table on every Nth burst tick
+    size_t max_incidents = 16;
+};
+
+// The 1 s collectors report trigger signals through observe_*(); the first
+// signal over its threshold wakes the capture thread (run()), which samples
+// CPU, interfaces and the top processes every interval_ms for window_ms with
+// its own baselines, then stores the result as one incident in the store.
+// With a governor, the capture's CPU time counts against the sampler budget
+// and degraded levels shorten or suppress captures.
+class BurstCapture {
+public:
+    BurstCapture(MemoryStore& store, BurstConfig config, SamplerGovernor* governor = nullptr);
+
+    void observe_cpu(double total_pct);
+    void observe_net_rx(double total_rx_bytes_per_s);
+    void observe_psi(const char* resource, double some_pct);
+
+    // Capture thread body; returns once 'running' turns false.
+    void run(std::atomic<bool>& running);
+
+private:
+    struct Trigger {
+        std::string reason;     // "cpu", "net_rx", "psi.memory", ...
+        double value = 0.0;
+        double threshold = 0.0;
+    };
+
+    void fire(Trigger trigger);
+    void capture(const Trigger& trigger, std::atomic<bool>& running);
+
+    MemoryStore& store_;
+    const BurstConfig config_;
+    SamplerGovernor* governor_;
+
+    std::mutex m_;
+    std::condition_variable cv_;
+    bool pending_ = false;
+    bool capturing_ = false;
+    Trigger trigger_;
+    int64_t quiet_until_ = 0;           // mono_ms
+    int64_t next_id_ = 1;
+
+    double rx_average_ = 0.0;           // EWMA of total rx, touched only by the network task
+    unsigned rx_observations_ = 0;
+};
+
+#endif //SYSTEM_MONITORING_DASHBOARD_BURST_H
@@ -0,0 +1,42 @@
+//
+// cgroup.h — per-cgroup CPU, memory, I/O and pressure from the cgroup v2 tree.
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_CGROUP_H
+#define SYSTEM_MONITORING_DASHBOARD_CGROUP_H
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "collector/pressure.h"
+
+struct CgroupStats {
+    std::string path;            // relative to the cgroup2 mount, e.g. "system.slice/nginx.service"
+
+    double cpu_pct = 0.0;        // usage_usec over wall time (100 = one core)
+    double cpu_throttled_pct = 0.0;
+    bool has_memory = false;
+    uint64_t mem_current = 0;    // memory.current
+    uint64_t mem_anon = 0;       // memory.stat anon
+    uint64_t mem_file = 0;       // memory.stat file
+    bool has_io = false;
+    double io_read_bytes_per_s = 0.0;
+    double io_write_bytes_per_s = 0.0;
+    PressurePct pressure[kPressureResourceCount];
+};
+
+struct CgroupLimits {
+    int max_depth = 2;        // levels below the mount point to track
+    size_t max_cgroups = 64;  // further cgroups are ignored until others go away
+};
+
+// Track cgroups below the cgroup2 mount (found at /sys/fs/cgroup or
+// /sys/fs/cgroup/unified). The tree is walked once; afterwards new and removed
+// cgroups arrive through inotify, and each tracked cgroup keeps its stat files
+// open. First call for a cgroup only establishes baselines (rates are 0).
+// Returns false when no cgroup2 hierarchy is mounted.
+bool get_cgroup_stats(const CgroupLimits& limits, std::vector<CgroupStats>& out);
+
+#endif //SYSTEM_MONITORING_DASHBOARD_CGROUP_H
@@ -6,13 +6,82 @@
 #define SYSTEM_MONITORING_DASHBOARD_CPU_H
 
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
+// Cumulative jiffies of one "cpu" / "cpuN" line of /proc/stat
+struct CpuTimes {
+    uint64_t user=0, nice=0, system=0, idle=0, iowait=0, irq=0, softirq=0, steal=0;
+    uint64_t guest=0, guest_nice=0; // already included in user / nice
+};
+
+// Counters from the non-cpu lines of /proc/stat
+struct SystemCounters {
+    uint64_t ctxt=0, intr=0, processes=0;   // cumulative since boot
+    uint64_t procs_running=0, procs_blocked=0;
+};
+
+// One parse of /proc/stat. The cpu task reads it once per tick and derives
+// total, per-core, per-mode and scheduler activity from it; each getter
+// below keeps its own baseline.
+struct ProcStat {
+    CpuTimes total;
+    std::vector<CpuTimes> per_cpu;  // cpu0, cpu1, ...
+    SystemCounters counters;
+};
+
+// Read the whole file into 'out' (reusing its storage). false if the
+// aggregate "cpu" line is missing.
+bool read_proc_stat(ProcStat& out);
+
 // Returns per-logical-CPU utilization (0..100). true if ok.
-bool get_cpu_core_percent(std::vector<double>& out_core_pct);
+bool get_cpu_core_percent(const ProcStat& stat, std::vector<double>& out_core_pct);
+
+// Returns total CPU utilization (0..100).
+double get_cpu_total_percent(const ProcStat& stat);
+
+// Modes reported by get_cpu_mode_percent, in column order.
+// user/nice exclude guest/guest_nice (the kernel counts guest time in both).
+enum CpuMode {
+    kCpuUser = 0, kCpuNice, kCpuSystem, kCpuIdle, kCpuIowait,
+    kCpuIrq, kCpuSoftirq, kCpuSteal, kCpuGuest, kCpuGuestNice,
+    kCpuModeCount
+};
+
+const char* cpu_mode_name(int mode);
+
+// Per-mode share of time (0..100) as a row-major matrix of
+// (cores + 1) rows x kCpuModeCount columns; the last row is the all-CPU total.
+// First call only primes the baseline and returns zeros. true if ok.
+bool get_cpu_mode_percent(const ProcStat& stat, std::vector<double>& out_matrix, size_t& out_cores);
+
+// Raw busy / total jiffies: index 0 is the all-CPU aggregate, 1..N the cores.
+// For callers that keep their own baselines (burst capture) instead of the
+// shared ones behind the getters above.
+struct CpuTicks {
+    uint64_t active = 0;
+    uint64_t total = 0;
+};
+
+bool read_cpu_ticks(std::vector<CpuTicks>& out);
+
+// System-wide scheduler activity from the non-cpu lines of /proc/stat.
+struct CpuActivity {
+    double ctxt_per_s = 0.0;      // context switches
+    double intr_per_s = 0.0;      // interrupts (all sources)
+    double forks_per_s = 0.0;     // "processes": forks + clones
+    uint64_t procs_running = 0;   // runnable tasks right now
+    uint64_t procs_blocked = 0;   // tasks blocked on I/O right now
+};
+
+// Rates are 0 on the first call.
+void get_cpu_activity(const ProcStat& stat, CpuActivity& out);
 
-// Returns total CPU utilization (0..100). <0 on error.
-double get_cpu_total_percent();
+// Per-logical-CPU time tasks spent runnable but waiting for the CPU, in ms
+// per second of wall time (can exceed 1000 with several waiters), from
+// /proc/schedstat. false when the kernel has no schedstat (CONFIG_SCHEDSTATS=n).
+bool get_cpu_runqueue_wait(std::vector<double>& out_wait_ms);
 
 
 #endif //SYSTEM_MONITORING_DASHBOARD_CPU_H
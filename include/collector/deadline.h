@@ -0,0 +1,45 @@
+//
+// deadline.h — absolute-deadline timing for the sampler.
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_DEADLINE_H
+#define SYSTEM_MONITORING_DASHBOARD_DEADLINE_H
+
+#pragma once
+#include <cstdint>
+
+// Sleeps until absolute CLOCK_MONOTONIC deadlines using a timerfd armed with
+// TFD_TIMER_ABSTIME, so time spent collecting never shifts the next wake-up.
+class DeadlineTimer {
+public:
+    DeadlineTimer();
+    ~DeadlineTimer();
+    DeadlineTimer(const DeadlineTimer&) = delete;
+    DeadlineTimer& operator=(const DeadlineTimer&) = delete;
+
+    // Block until mono_ms() >= deadline_ms; returns at once if already past.
+    void wait_until(int64_t deadline_ms);
+
+private:
+    int fd_ = -1;
+};
+
+// Fixed grid of deadlines 'period_ms' apart on the monotonic clock, phased so
+// that the matching wall-clock times fall on multiples of the period.
+class TickSchedule {
+public:
+    explicit TickSchedule(int64_t period_ms);
+
+    int64_t period_ms() const { return period_ms_; }
+    int64_t next_deadline() const { return next_deadline_; }
+
+    // Move to the first grid deadline after 'now_mono_ms'. Returns how many
+    // deadlines were skipped because the tick overran them (0 when on time).
+    int64_t advance(int64_t now_mono_ms);
+
+private:
+    int64_t period_ms_;
+    int64_t next_deadline_;
+};
+
+#endif //SYSTEM_MONITORING_DASHBOARD_DEADLINE_H
@@ -0,0 +1,93 @@
+//
+// executor.h — runs registered collector tasks on a few deadline-driven lanes.
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_EXECUTOR_H
+#define SYSTEM_MONITORING_DASHBOARD_EXECUTOR_H
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct CollectorTask {
+    std::string name;             // "cpu", "process", ... (task label on self.* series)
+    int64_t period_ms = 1000;
+    int64_t deadline_ms = 0;      // must finish this long after its scheduled start; 0 = one period
+    int lane = 0;                 // executor thread the task always runs on
+    std::function<size_t(int64_t timestamp_ms)> run;   // returns items processed (PIDs, devices, ...)
+};
+
+// CPU time (user + system) consumed so far by the calling thread; 0 where
+// RUSAGE_THREAD is unavailable.
+int64_t thread_cpu_us();
+
+// What happened on one run of a task, handed to the observer.
+struct TaskRun {
+    const CollectorTask* task = nullptr;
+    int64_t timestamp_ms = 0;     // wall clock passed to run()
+    int64_t duration_us = 0;
+    int64_t start_lag_us = 0;     // jitter: how long after its scheduled deadline the run started
+    int64_t lateness_us = 0;      // how far past its deadline it finished (0 when on time)
+    int64_t cpu_us = 0;           // CPU time of the lane thread during run() (getrusage RUSAGE_THREAD)
+    int64_t missed = 0;           // later deadlines skipped because this run overran them
+    bool late = false;            // finished after its deadline
+    size_t items = 0;             // what run() returned
+};
+
+// Each lane is one thread with its own timerfd; it sleeps until the earliest
+// deadline among its tasks, runs whatever is due, and moves those tasks along
+// their own TickSchedule grid. A slow task therefore only delays tasks on the
+// same lane.
+class CollectorExecutor {
+public:
+    void add(CollectorTask task);
+
+    // Change a task's period while running (<= 0 restores the period it was
+    // added with); its lane re-phases the task onto the new grid at its next
+    // wake-up. Unknown names are ignored.
+    void set_period(const std::string& task, int64_t period_ms);
+
+    // Stretch a task's period by 'scale' (>= 1) on top of set_period(), or
+    // stop running it altogether while 'paused'; used by the CPU governor.
+    void set_period_scale(const std::string& task, double scale);
+    void set_paused(const std::string& task, bool paused);
+
+    std::vector<std::string> task_names() const;
+
+    // Shortest period set for the tasks on 'lane' (the governor's scaling
+    // aside); 0 when the lane has none.
+    int64_t shortest_period_ms(int lane) const;
+
+    // Run all lanes until 'running' turns false (lane 0 uses the calling
+    // thread). 'observer' is called on the task's lane after every run.
+    void run(std::atomic<bool>& running, const std::function<void(const TaskRun&)>& observer);
+
+private:
+    struct Scheduled;
+
+    // Per-task knobs that may change while lanes run
+    struct Control {
+        int64_t period_ms = 0;        // current, from set_period()
+        int64_t added_period_ms = 0;  // given to add()
+        double scale = 1.0;
+        bool paused = false;
+    };
+
+    void apply_controls(std::vector<Scheduled>& lane);
+    void run_lane(std::vector<Scheduled> lane,
+                  std::atomic<bool>& running,
+                  const std::function<void(const TaskRun&)>& observer);
+
+    std::vector<CollectorTask> tasks_;
+
+    mutable std::mutex control_mtx_;
+    std::unordered_map<std::string, Control> controls_;
+    std::atomic<unsigned> control_generation_{0};
+};
+
+#endif //SYSTEM_MONITORING_DASHBOARD_EXECUTOR_H
@@ -0,0 +1,31 @@
+//
+// fs.h — filesystem capacity and inode usage per mount.
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_FS_H
+#define SYSTEM_MONITORING_DASHBOARD_FS_H
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct FsUsage {
+    std::string mount;        // mount point
+    std::string fstype;
+    uint64_t size_bytes = 0;
+    uint64_t used_bytes = 0;
+    uint64_t avail_bytes = 0; // available to unprivileged users (f_bavail)
+    uint64_t inodes_total = 0;
+    uint64_t inodes_used = 0;
+    uint64_t inodes_free = 0;
+};
+
+// statvfs every real (block-backed, non-network) mount once per device.
+// The mount table is re-parsed only when /proc/self/mountinfo signals a change
+// (POLLPRI). Each statvfs runs off-thread with a timeout; a mount that does not
+// answer in time is skipped until its pending call returns. true if the mount
+// table could be read.
+bool get_fs_usage(std::vector<FsUsage>& out);
+
+#endif //SYSTEM_MONITORING_DASHBOARD_FS_H
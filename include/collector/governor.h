@@ -0,0 +1,68 @@
+//
+// governor.h — keeps the sampler's own CPU use under a budget.
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_GOVERNOR_H
+#define SYSTEM_MONITORING_DASHBOARD_GOVERNOR_H
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "collector/executor.h"
+#include "store/memory_store.h"
+
+struct GovernorConfig {
+    double budget_pct = 1.0;        // of one core; <= 0 disables the governor
+    int64_t window_ms = 10000;      // CPU use is judged over this much wall time
+    unsigned calm_windows = 3;      // windows under half the budget before stepping back
+};
+
+// Fed every TaskRun (its getrusage(RUSAGE_THREAD) delta) and the burst
+// capture's CPU time (charge()), the governor sums the sampler's CPU time per
+// window. Over budget it moves one degradation level up; after calm_windows
+// well under budget, one level down:
+//   0 normal
+//   1 process scan every 2nd tick, process table halved, burst captures
+//     half as long
+//   2 process scan every 4th tick, table quartered, irq / sensors / netns /
+//     cgroup / filesystem every 4th tick, no burst captures
+//   3 as 2, with process every 8th tick and irq / sensors / netns / cgroup
+//     paused
+// The level is published as self.cpu_pct / self.degradation_level{host} and
+// the "governor" snapshot shown by /api/status.
+class SamplerGovernor {
+public:
+    SamplerGovernor(CollectorExecutor& executor, MemoryStore& store, GovernorConfig config);
+
+    void observe(const TaskRun& run);
+
+    int level() const { return level_.load(std::memory_order_relaxed); }
+
+    // Process table rows allowed at the current level
+    size_t process_table_limit(size_t configured) const;
+
+    // CPU time spent outside the lanes (the burst capture thread)
+    void charge(int64_t cpu_us);
+
+    // Burst capture length allowed at the current level; 0 suppresses captures
+    int64_t burst_window_ms(int64_t configured) const;
+
+private:
+    void close_window(int64_t mono_now_ms, int64_t timestamp_ms);
+    void apply_level(int level);
+
+    CollectorExecutor& executor_;
+    MemoryStore& store_;
+    const GovernorConfig config_;
+    std::atomic<int> level_{0};
+
+    std::mutex m_;    // guards the window state
+    int64_t window_start_ms_ = 0;
+    int64_t window_cpu_us_ = 0;
+    unsigned calm_ = 0;
+    int64_t changed_ms_ = 0;
+};
+
+#endif //SYSTEM_MONITORING_DASHBOARD_GOVERNOR_H
@@ -0,0 +1,26 @@
+//
+// irq.h — per-CPU interrupt and softirq rates from /proc/interrupts and /proc/softirqs.
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_IRQ_H
+#define SYSTEM_MONITORING_DASHBOARD_IRQ_H
+
+#pragma once
+#include <string>
+#include <vector>
+
+struct IrqRates {
+    std::string name;                 // "24", "NMI", "NET_RX", ...
+    std::string desc;                 // chip / handler text after the counters (interrupts only)
+    std::vector<double> per_cpu;      // events/sec, one entry per CPU column
+    double total = 0.0;               // sum of per_cpu
+};
+
+// Rows whose counters never moved since start (or since the row list last
+// changed) are left out to keep idle IRQ lines from becoming series. First
+// call primes baselines (empty output).
+bool get_interrupt_rates(std::vector<IrqRates>& out);
+
+bool get_softirq_rates(std::vector<IrqRates>& out);
+
+#endif //SYSTEM_MONITORING_DASHBOARD_IRQ_H
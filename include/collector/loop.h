@@ -12,7 +12,10 @@
 
 /**
  * Launch a background worker that captures CPU, memory, disk, network, and
- * process metrics at cfg::SAMPLE_PERIOD_S intervals.
+ * process metrics. Each collector is a CollectorExecutor task with its own
+ * period (cfg::SAMPLE_PERIOD_S, or cfg::FS_PERIOD_S for filesystems) and lane
+ * thread; ticks follow absolute CLOCK_MONOTONIC deadlines, and overruns are
+ * recorded as self.missed_ticks / self.deadline_misses per task.
  *
  * @param store   Shared MemoryStore instance populated with samples.
  * @param running Atomic flag toggled by the caller to stop the loop.
@@ -10,7 +10,23 @@
 
 struct MemBytes { uint64_t used_bytes=0, free_bytes=0, total_bytes=0;}; // free = available
 
+// The /proc/meminfo fields we publish, in bytes (hugepage counts are pages).
+struct MemDetail {
+    uint64_t total=0, free=0, available=0, buffers=0, cached=0, shmem=0;
+    uint64_t dirty=0, writeback=0, anon=0, anon_huge=0;
+    uint64_t slab=0, slab_reclaimable=0, slab_unreclaimable=0;
+    uint64_t swap_total=0, swap_free=0, swap_cached=0;
+    uint64_t hugepages_total=0, hugepages_free=0, hugepage_size=0;
+    bool has_available = false; // MemAvailable missing on very old kernels
+};
+
 bool get_system_memory_bytes(MemBytes& mb);
 
+// Parse /proc/meminfo against a fixed key table. false if MemTotal is missing.
+bool get_system_memory_detail(MemDetail& md);
+
+// MemAvailable, or MemFree + Buffers + Cached - Shmem on kernels without it
+uint64_t memory_available_bytes(const MemDetail& md);
+
 
 #endif //SYSTEM_MONITORING_DASHBOARD_MEMORY_H
@@ -9,6 +9,7 @@
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 struct InterfaceRates {
     double rx_bytes_per_s = 0.0;
@@ -23,6 +24,44 @@ struct InterfaceCounters {
 // Full type must be known *here* (not just a forward-declare).
 using NetSnapshot = std::unordered_map<std::string, InterfaceCounters>;
 
+// Interface counters come from one of two backends (cfg::NET_USE_NETLINK):
+//  - /proc/net/dev -> text parse (default)
+//  - rtnetlink     -> one RTM_GETSTATS dump of 64-bit counters, better with thousands of links
+// One entry of the netlink link table, indexed by ifindex.
+// 'present' is cleared before every dump so vanished links can be skipped.
+struct LinkSlot {
+    bool present = false;
+    std::string name;
+    InterfaceCounters counters;
+};
+
+struct LinkTable {
+    std::vector<LinkSlot> slots;
+    unsigned reads_since_names = ~0u;  // forces a name dump on first use
+};
+
+// Parse /proc/net/dev into 'out' (loopback skipped).
+bool read_proc_net_dev(NetSnapshot& out);
+
+// Open a NETLINK_ROUTE socket bound to the calling thread's network namespace.
+int open_netlink_socket();
+
+// Dump 64-bit link counters over rtnetlink into 'table' (loopback skipped).
+// The table is grown to the highest ifindex seen and reused between calls.
+// 'fd' selects a socket from open_netlink_socket(); -1 uses the process-wide one,
+// whose dumps are serialized. Safe to call from several threads at once as long
+// as each passes its own table (and each own socket is used by one thread).
+bool read_netlink_links(LinkTable& table, int fd = -1);
+
+// Counters from whichever backend cfg::NET_USE_NETLINK selects, as a name map.
+// 'table' is the netlink backend's scratch, reused between calls.
+bool read_interface_counters(NetSnapshot& out, LinkTable& table);
+
+// Per-interface byte rates between two link tables taken dt_s seconds apart.
+// Slots are matched by ifindex and name so a reused ifindex never produces a bogus delta.
+void compute_link_rates(const LinkTable& prev, const LinkTable& curr, double dt_s,
+                        std::unordered_map<std::string, InterfaceRates>& out);
+
 bool get_net_stats(std::unordered_map<std::string, InterfaceRates>& out);
 
 #endif //SYSTEM_MONITORING_DASHBOARD_NET_H
@@ -0,0 +1,31 @@
+//
+// netns.h — interface rates for network namespaces other than our own.
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_NETNS_H
+#define SYSTEM_MONITORING_DASHBOARD_NETNS_H
+
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "collector/net.h"
+
+struct NetnsRates {
+    std::string label;  // owning container id (12 chars) or "ns-<inode>"
+    std::unordered_map<std::string, InterfaceRates> ifaces;
+};
+
+// Discover network namespaces through /proc/[pid]/ns/net (deduplicated by inode,
+// our own namespace excluded) and return per-interface rates for each of them.
+// Work runs on a dedicated helper thread that enters each namespace with setns
+// once to open a netlink socket there; namespace fds and sockets are cached, so
+// per-tick cost scales with namespaces, not processes. Needs CAP_SYS_ADMIN.
+// A namespace whose dump fails is dropped at once; one whose socket could not
+// be opened is retried at each discovery.
+// Returns false for good once the helper fails to setns back into its own
+// namespace, since every socket it opened afterwards would be misattributed.
+bool get_netns_net_stats(std::vector<NetnsRates>& out);
+
+#endif //SYSTEM_MONITORING_DASHBOARD_NETNS_H
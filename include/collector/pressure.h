@@ -0,0 +1,46 @@
+//
+// pressure.h — Linux pressure stall information (/proc/pressure/*).
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_PRESSURE_H
+#define SYSTEM_MONITORING_DASHBOARD_PRESSURE_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Share of wall time (0..100) in which some / all runnable tasks were stalled
+// on a resource, computed from the "total=" microsecond counters between calls.
+struct PressurePct {
+    double some_pct = 0.0;
+    double full_pct = 0.0;
+    bool has_full = false;  // cpu "full" only exists on newer kernels
+    bool valid = false;     // false without a previous reading to diff against
+};
+
+// Raw cumulative stall counters (microseconds) from one PSI file.
+struct PressureTotals {
+    uint64_t some_us = 0;
+    uint64_t full_us = 0;
+    bool has_full = false;
+};
+
+enum PressureResource { kPressureCpu = 0, kPressureMemory, kPressureIo, kPressureResourceCount };
+
+// Resource names used as the "resource" label ("cpu", "memory", "io").
+const char* pressure_resource_name(int resource);
+
+// Parse the some/full "total=" counters of a PSI file (system-wide or cgroup *.pressure).
+bool parse_pressure_totals(const char* buf, size_t len, PressureTotals& t);
+
+// Stall share between two readings taken dt_us microseconds apart; not valid
+// when dt_us is 0 (no previous reading).
+PressurePct pressure_pct_between(const PressureTotals& prev, const PressureTotals& cur, double dt_us);
+
+// Fill 'out' for every resource. Returns false when PSI is unavailable
+// (CONFIG_PSI off or psi=0). An entry is valid only when its file was read
+// now and on the previous call, so first readings and unreadable resources
+// are not reported as 0%.
+bool get_pressure_pct(PressurePct (&out)[kPressureResourceCount]);
+
+#endif //SYSTEM_MONITORING_DASHBOARD_PRESSURE_H
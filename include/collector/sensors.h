@@ -0,0 +1,26 @@
+//
+// sensors.h — per-core clock frequency and temperature sensors from sysfs.
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_SENSORS_H
+#define SYSTEM_MONITORING_DASHBOARD_SENSORS_H
+
+#pragma once
+#include <string>
+#include <vector>
+
+struct TempReading {
+    std::string sensor;     // "<hwmon name>/<label>" or "thermal/<zone type>"
+    double celsius = 0.0;
+};
+
+// Current frequency in MHz of every online CPU, in the same order as the
+// cpuN lines of /proc/stat (and therefore cpu.core_pct). A core whose
+// scaling_cur_freq cannot be read reports 0. false when cpufreq is absent.
+bool get_cpu_frequency_mhz(std::vector<double>& out_mhz);
+
+// hwmon temp*_input and thermal_zone*/temp readings. false when the host
+// exposes no temperature sensors (typical inside VMs).
+bool get_temperatures(std::vector<TempReading>& out);
+
+#endif //SYSTEM_MONITORING_DASHBOARD_SENSORS_H
@@ -0,0 +1,53 @@
+//
+// telemetry.h — the sampler's own cost: per-task latency, jitter and load.
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_TELEMETRY_H
+#define SYSTEM_MONITORING_DASHBOARD_TELEMETRY_H
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "collector/executor.h"
+#include "store/memory_store.h"
+
+// Upper bounds (ms) of the duration histogram buckets; the last one is open.
+constexpr std::array<double, 13> kTaskDurationBucketsMs = {
+        0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50, 100, 250, 500, 1000
+};
+
+// Executor observer that turns every TaskRun into self.* series:
+//   self.task_duration_ms, self.task_duration_hist (runs per bucket since
+//   start), self.tick_jitter_ms, self.lateness_ms, self.items,
+//   self.store_appends, self.store_append_us, self.missed_ticks,
+//   self.deadline_misses — all labelled {host, task}.
+// A per-task summary is kept as the "self" snapshot (served by /api/status),
+// refreshed at most once per second.
+class SelfTelemetry {
+public:
+    explicit SelfTelemetry(MemoryStore& store);
+    ~SelfTelemetry();
+
+    // Call on the task's lane right after the run; the lane's store appends
+    // since the previous call are charged to this run and returned.
+    AppendStats record(const TaskRun& run);
+
+private:
+    struct TaskStats;
+
+    TaskStats& stats_for(const std::string& task);
+    void publish_summary();
+
+    MemoryStore& store_;
+
+    std::mutex m_;    // guards everything below
+    std::unordered_map<std::string, std::unique_ptr<TaskStats>> tasks_;
+    int64_t last_summary_ms_ = 0;
+};
+
+#endif //SYSTEM_MONITORING_DASHBOARD_TELEMETRY_H
@@ -0,0 +1,23 @@
+//
+// vmstat.h — paging, reclaim and swap event rates from /proc/vmstat.
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_VMSTAT_H
+#define SYSTEM_MONITORING_DASHBOARD_VMSTAT_H
+
+#pragma once
+#include <string>
+#include <vector>
+
+struct VmstatRate {
+    std::string key;       // vmstat counter name, e.g. "pgmajfault"
+    double per_s = 0.0;
+};
+
+// Events/sec for each of cfg::VMSTAT_KEYS present in /proc/vmstat (unknown
+// keys are skipped). Keys are resolved to line positions on the first call
+// and again only when the file's line count changes. First call after a
+// resolve primes baselines (empty output). true if ok.
+bool get_vmstat_rates(std::vector<VmstatRate>& out);
+
+#endif //SYSTEM_MONITORING_DASHBOARD_VMSTAT_H
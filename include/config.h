@@ -7,6 +7,7 @@
 
 #pragma once
 #include <string>
+#include <vector>
 #include <cstdlib>
 #include <unistd.h>
 
@@ -23,9 +24,89 @@ namespace cfg {
         return "unknown";
     }
 
+    // NET_BACKEND=netlink reads interface counters over rtnetlink instead of /proc/net/dev
+    inline bool resolve_net_use_netlink(){
+        const char* env = std::getenv("NET_BACKEND");
+        return env && std::string(env) == "netlink";
+    }
+
+    // NET_NAMESPACES=1 also collects interface stats inside other network namespaces
+    inline bool resolve_net_namespaces(){
+        const char* env = std::getenv("NET_NAMESPACES");
+        return env && std::string(env) == "1";
+    }
+
+    // IRQ_PER_CPU=1 also stores per-CPU interrupt / softirq rates (ncpu values per sample)
+    inline bool resolve_irq_per_cpu(){
+        const char* env = std::getenv("IRQ_PER_CPU");
+        return env && std::string(env) == "1";
+    }
+
+    // Integer env override with fallback (non-numeric or <= 0 values are ignored)
+    inline int resolve_env_int(const char* name, int fallback){
+        const char* env = std::getenv(name);
+        if(!env || !*env) return fallback;
+        const int v = std::atoi(env);
+        return v > 0 ? v : fallback;
+    }
+
+    // BURST_CAPTURE=0 turns off triggered high-frequency capture
+    inline bool resolve_burst_capture(){
+        const char* env = std::getenv("BURST_CAPTURE");
+        return !(env && std::string(env) == "0");
+    }
+
+    // CPU_BUDGET_PCT=2.5 lets the sampler use 2.5% of one core before the governor
+    // degrades collection; 0 turns the governor off
+    inline double resolve_cpu_budget_pct(){
+        const char* env = std::getenv("CPU_BUDGET_PCT");
+        if(!env || !*env) return 1.0;
+        const double v = std::atof(env);
+        return v > 0 ? v : 0.0;
+    }
+
+    // VMSTAT_KEYS=pgmajfault,pswpin,... picks the /proc/vmstat counters published as rates
+    inline std::vector<std::string> resolve_vmstat_keys(){
+        const char* env = std::getenv("VMSTAT_KEYS");
+        if(!env || !*env){
+            return {"pgfault", "pgmajfault", "pswpin", "pswpout",
+                    "pgscan_kswapd", "pgscan_direct", "pgsteal_kswapd", "pgsteal_direct",
+                    "compact_stall", "thp_fault_alloc", "thp_fault_fallback", "oom_kill"};
+        }
+
+        std::vector<std::string> keys;
+        std::string key;
+        for(const char* c = env; ; ++c){
+            if(*c == ',' || *c == '\0'){
+                if(!key.empty()) keys.push_back(key);
+                key.clear();
+                if(*c == '\0') break;
+            } else if(*c != ' '){
+                key.push_back(*c);
+            }
+        }
+        return keys;
+    }
+
     inline constexpr int SAMPLE_PERIOD_S   = 1;
     inline constexpr int KEEP_SECONDS      = 7200;   // ring capacity hint
     inline const std::string HOST_LABEL    = resolve_host_name();
+    inline const bool NET_USE_NETLINK      = resolve_net_use_netlink();
+    inline const bool NET_NAMESPACES       = resolve_net_namespaces();
+    inline const bool IRQ_PER_CPU          = resolve_irq_per_cpu();
+    inline const int CGROUP_MAX_DEPTH      = resolve_env_int("CGROUP_MAX_DEPTH", 2);
+    inline const int CGROUP_MAX_SERIES     = resolve_env_int("CGROUP_MAX_SERIES", 64);  // cgroups tracked
+    inline const int FS_PERIOD_S           = resolve_env_int("FS_PERIOD_S", 30);  // statvfs sweep cadence
+    inline const bool BURST_CAPTURE        = resolve_burst_capture();
+    inline const int BURST_CPU_PCT         = resolve_env_int("BURST_CPU_PCT", 90);
+    inline const int BURST_PSI_PCT         = resolve_env_int("BURST_PSI_PCT", 10);
+    inline const int BURST_INTERVAL_MS     = resolve_env_int("BURST_INTERVAL_MS", 50);
+    inline const int BURST_WINDOW_MS       = resolve_env_int("BURST_WINDOW_MS", 5000);
+    inline const int BURST_COOLDOWN_S      = resolve_env_int("BURST_COOLDOWN_S", 60);
+    inline const double CPU_BUDGET_PCT     = resolve_cpu_budget_pct();
+    inline const int STREAM_MAX_CLIENTS    = resolve_env_int("STREAM_MAX_CLIENTS", 32);  // concurrent /api/stream
+    inline const int QUERY_CACHE_MB        = resolve_env_int("QUERY_CACHE_MB", 16);  // cached /api/query bodies
+    inline const std::vector<std::string> VMSTAT_KEYS = resolve_vmstat_keys();
 }
 
 #endif //SYSTEM_MONITORING_DASHBOARD_CONFIG_H
@@ -8,8 +8,12 @@
 #pragma once
 #include <string>
 #include <initializer_list>
+#include <sstream>
+#include <unordered_map>
 #include <utility>
 
+// Selector keys are "name{k=v,...}". Collectors list "host" first and the
+// remaining labels alphabetically; the API builds selectors in the same order.
 inline std::string metric_with_labels(
         const std::string& name,
         std::initializer_list<std::pair<std::string,std::string>> kvs)
@@ -25,4 +29,42 @@ inline std::string metric_with_labels(
     return out;
 }
 
+struct MetricSelectorParts {
+    std::string metric;
+    std::unordered_map<std::string, std::string> labels;
+};
+
+// Split a selector built by metric_with_labels() back into name and labels.
+inline MetricSelectorParts parse_selector(const std::string& selector) {
+    MetricSelectorParts parts;
+
+    const auto open_brace = selector.find('{');
+    if (open_brace == std::string::npos) {
+        parts.metric = selector;
+        return parts;
+    }
+
+    parts.metric = selector.substr(0, open_brace);
+    const auto close_brace = selector.find('}', open_brace);
+    if (close_brace == std::string::npos) {
+        return parts;
+    }
+
+    std::string inside = selector.substr(open_brace + 1, close_brace - open_brace - 1);
+    std::istringstream inside_stream(inside);
+    std::string token;
+    while (std::getline(inside_stream, token, ',')) {
+        const auto equals = token.find('=');
+        if (equals == std::string::npos) {
+            continue;
+        }
+
+        std::string key = token.substr(0, equals);
+        std::string value = token.substr(equals + 1);
+        parts.labels[key] = value;
+    }
+
+    return parts;
+}
+
 #endif //SYSTEM_MONITORING_DASHBOARD_METRICS_KEY_H
@@ -14,4 +14,32 @@ inline int64_t now_ms() {
             std::chrono::system_clock::now().time_since_epoch()).count();
 }
 
+// Monotonic milliseconds (CLOCK_MONOTONIC on Linux). For intervals only;
+// unaffected by NTP steps, never stored.
+inline int64_t mono_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Monotonic microseconds, for timing the agent's own work.
+inline int64_t mono_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline int64_t& tick_mono_slot() {
+    static thread_local int64_t tick = 0;
+    return tick;
+}
+
+// The sampler stamps each tick once; collectors use tick_mono_ms() for their
+// rate dt so every series of one tick shares the same time base. Outside a
+// tick (or on helper threads) it falls back to mono_ms().
+inline void set_tick_mono_ms(int64_t tick) { tick_mono_slot() = tick; }
+
+inline int64_t tick_mono_ms() {
+    const int64_t tick = tick_mono_slot();
+    return tick != 0 ? tick : mono_ms();
+}
+
 #endif //SYSTEM_MONITORING_DASHBOARD_TIME_H
@@ -0,0 +1,92 @@
+//
+// downsample.h — server-side reduction of long ranges to screen-sized ones.
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_DOWNSAMPLE_H
+#define SYSTEM_MONITORING_DASHBOARD_DOWNSAMPLE_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Sample;
+struct SampleVec;
+
+// A ring's elements as at most two contiguous runs, oldest first (the run up
+// to the end of the buffer, then the wrapped one). Valid while the series
+// lock that produced it is held.
+template<typename T>
+struct RingSpans {
+    const T* first = nullptr;
+    std::size_t first_size = 0;
+    const T* second = nullptr;
+    std::size_t second_size = 0;
+
+    std::size_t size() const { return first_size + second_size; }
+
+    const T& operator[](std::size_t i) const { return i < first_size ? first[i] : second[i - first_size]; }
+
+    // Call fn(ptr, n, offset) for the contiguous pieces of [begin, end),
+    // 'offset' being the logical index of ptr[0].
+    template<typename Fn>
+    void for_each_run(std::size_t begin, std::size_t end, Fn&& fn) const {
+        if (begin < first_size) {
+            const std::size_t stop = end < first_size ? end : first_size;
+            fn(first + begin, stop - begin, begin);
+            begin = stop;
+        }
+        if (begin < end) fn(second + (begin - first_size), end - begin, begin);
+    }
+};
+
+enum class DownsampleAgg {
+    kNone,      // raw samples
+    kLttb,      // Largest-Triangle-Three-Buckets: keeps the visual shape, scalar only
+    kMinMax,    // each bucket's lowest and highest sample, scalar only
+    kAvg,
+    kMin,
+    kMax
+};
+
+// What a reader asked for: at most max_points samples and/or buckets step_ms
+// wide (the coarser of the two wins). Zero means "not given".
+struct DownsampleSpec {
+    DownsampleAgg agg = DownsampleAgg::kNone;
+    std::size_t max_points = 0;
+    std::int64_t step_ms = 0;
+};
+
+// What was actually done; agg is kNone when the range was already small
+// enough and came back raw.
+struct DownsampleInfo {
+    DownsampleAgg agg = DownsampleAgg::kNone;
+    std::int64_t step_ms = 0;
+    std::size_t source_points = 0;
+};
+
+bool parse_downsample_agg(const std::string& name, DownsampleAgg& agg);
+
+const char* downsample_agg_name(DownsampleAgg agg);
+
+// Reduce 'in' (timestamps ascending) into 'out'. Bucketed aggregates are
+// stamped with the bucket start, aligned to multiples of the step so that
+// repeated queries and different series line up; LTTB and min/max return
+// original samples. Vector series support avg/min/max element-wise (LTTB and
+// min/max fall back to avg).
+DownsampleInfo downsample(const RingSpans<Sample>& in, const DownsampleSpec& spec, std::vector<Sample>& out);
+
+DownsampleInfo downsample(const RingSpans<SampleVec>& in, const DownsampleSpec& spec, std::vector<SampleVec>& out);
+
+// Spans over a plain vector (already-copied samples)
+template<typename T>
+RingSpans<T> spans_of(const std::vector<T>& v) {
+    RingSpans<T> s;
+    s.first = v.data();
+    s.first_size = v.size();
+    return s;
+}
+
+#endif //SYSTEM_MONITORING_DASHBOARD_DOWNSAMPLE_H
@@ -0,0 +1,73 @@
+//
+// label_index.h — inverted index of stored series: metric -> label -> value
+// -> series ids.
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_LABEL_INDEX_H
+#define SYSTEM_MONITORING_DASHBOARD_LABEL_INDEX_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class SeriesKind { kScalar, kVector, kMatrix };
+
+const char* series_kind_name(SeriesKind kind);
+
+// One metric as listed by LabelIndex::metrics(); label values sorted
+struct MetricLabels {
+    std::string name;
+    SeriesKind kind = SeriesKind::kScalar;
+    std::size_t series = 0;
+    std::map<std::string, std::vector<std::string>> labels;
+};
+
+// Not thread-safe; MemoryStore guards its index. Updated only when a series
+// is created, retired or turns into a matrix, so reads never parse selectors.
+class LabelIndex {
+public:
+    using SeriesId = std::uint32_t;
+
+    // Index a new series under its metric name and labels. A metric's kind
+    // only moves up (scalar < vector < matrix).
+    SeriesId add(const std::string& selector, SeriesKind kind);
+
+    // Forget a retired series; its id is reused. A metric left without series
+    // disappears from listings. False if 'selector' was not indexed.
+    bool remove(const std::string& selector);
+
+    // Raise the kind of the metric 'selector' belongs to (e.g. once a vector
+    // series is given a matrix shape)
+    void set_kind(const std::string& selector, SeriesKind kind);
+
+    // Metrics whose name starts with 'prefix' (all for ""), by name
+    std::vector<MetricLabels> metrics(const std::string& prefix = {}) const;
+
+    // Sorted values of 'label' across the metric's series (empty if unknown)
+    std::vector<std::string> label_values(const std::string& metric, const std::string& label) const;
+
+    // Selectors of the metric's series carrying label=value, in the order indexed
+    std::vector<std::string> series(const std::string& metric, const std::string& label,
+                                    const std::string& value) const;
+
+    std::size_t size() const { return ids_.size(); }
+
+private:
+    struct Metric {
+        SeriesKind kind = SeriesKind::kScalar;
+        std::size_t series = 0;
+        std::map<std::string, std::map<std::string, std::vector<SeriesId>>> postings;
+    };
+
+    std::vector<std::string> selectors_;    // by SeriesId; empty for free ids
+    std::vector<SeriesId> free_ids_;
+    std::unordered_map<std::string, SeriesId> ids_;
+    std::map<std::string, Metric> metrics_;
+};
+
+#endif //SYSTEM_MONITORING_DASHBOARD_LABEL_INDEX_H
@@ -7,12 +7,22 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstddef>
+#include <deque>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <string>
 #include <unordered_map>
 #include <mutex>
+#include <optional>
+#include "store/downsample.h"
+#include "store/label_index.h"
+#include "store/versioned_table.h"
 #include "third_party/json.hpp"
 
 struct Sample {
@@ -25,6 +35,57 @@ struct SampleVec{
     std::vector<double> vals;
 };
 
+// Row/column labels of a vector series that holds a row-major matrix per sample
+// (e.g. core x mode). Empty for plain vector series.
+struct MatrixShape {
+    std::vector<std::string> rows;
+    std::vector<std::string> columns;
+
+    bool operator==(const MatrixShape& other) const { return rows == other.rows && columns == other.columns; }
+    bool operator!=(const MatrixShape& other) const { return !(*this == other); }
+};
+
+// Appends made by one thread and the time spent inside them, accumulated
+// until the next MemoryStore::take_thread_append_stats() on that thread.
+struct AppendStats {
+    std::uint64_t appends = 0;
+    std::int64_t elapsed_ns = 0;
+};
+
+// Retention in samples for the series of one family picked by the value of
+// one label, e.g. self.* by "task" (see MemoryStore::set_retention)
+struct LabelRetention {
+    std::string family;
+    std::string label;
+    std::unordered_map<std::string, std::size_t> by_value;
+};
+
+// One series read of a batch (see MemoryStore::query_batch)
+struct SeriesQuery {
+    std::string selector;
+    std::int64_t from_ms{};
+    std::int64_t to_ms{};
+    DownsampleSpec downsample;          // agg kNone: raw samples
+};
+
+struct SeriesResult {
+    bool is_vector = false;
+    std::vector<Sample> samples;        // scalar series
+    std::vector<SampleVec> vec_samples; // vector series
+    MatrixShape shape;                  // vector series only
+    DownsampleInfo downsample;
+};
+
+// Newest sample of one series (see MemoryStore::latest_samples)
+struct LatestSample {
+    std::string selector;
+    bool is_vector = false;
+    std::int64_t ts_ms{};
+    std::int64_t interval_ms{};         // since the sample before; 0 if there is none
+    std::vector<double> vals;           // a single value for scalar series
+    MatrixShape shape;                  // vector series only
+};
+
 template<typename T>
 class RingBuffer {
 
@@ -85,6 +146,73 @@ public:
         return out;
     }
 
+    // Elements stamped in [from_ms, to_ms] as at most two contiguous runs of
+    // the buffer, without copying. Edges are found by binary search, so this
+    // relies on timestamps ascending (range() filters element by element).
+    RingSpans<T> spans(std::int64_t from_ms, std::int64_t to_ms) const {
+        const std::size_t first = first_index_not_before(from_ms);
+        const std::size_t last = to_ms == std::numeric_limits<std::int64_t>::max()
+                                 ? size_ : first_index_not_before(to_ms + 1);
+
+        RingSpans<T> out;
+        if (first >= last) return out;
+        const std::size_t start = (tail_ + first) % cap_;
+        const std::size_t n = last - first;
+        out.first = buffer_.data() + start;
+        out.first_size = std::min(n, cap_ - start);
+        if (out.first_size < n) {
+            out.second = buffer_.data();
+            out.second_size = n - out.first_size;
+        }
+        return out;
+    }
+
+    // Elements stamped after 'after_ms', oldest first. Walks back from the
+    // newest element, so the cost is the number returned, not the capacity.
+    std::vector<T> newer_than(std::int64_t after_ms) const {
+        std::size_t n = 0;
+        while (n < size_ && buffer_[(tail_ + size_ - 1 - n) % cap_].ts_ms > after_ms) n++;
+
+        std::vector<T> out;
+        out.reserve(n);
+        for (std::size_t i = size_ - n; i < size_; i++) {
+            out.push_back(buffer_[(tail_ + i) % cap_]);
+        }
+        return out;
+    }
+
+    // Stamp of the oldest element stamped at or after 'ts_ms', if any
+    std::optional<std::int64_t> first_ts_not_before(std::int64_t ts_ms) const {
+        const std::size_t first = first_index_not_before(ts_ms);
+        if (first >= size_) return std::nullopt;
+        return buffer_[(tail_ + first) % cap_].ts_ms;
+    }
+
+    // Newest element, or nullptr when empty
+    const T* newest() const { return size_ ? &buffer_[(tail_ + size_ - 1) % cap_] : nullptr; }
+
+    // Element just before the newest, or nullptr with fewer than two
+    const T* second_newest() const { return size_ > 1 ? &buffer_[(tail_ + size_ - 2) % cap_] : nullptr; }
+
+    // Change capacity in place, keeping the newest min(size, cap) elements in order.
+    void resize(std::size_t cap) {
+        if (cap == cap_ || cap == 0) return;
+
+        const std::size_t keep = std::min(size_, cap);
+        std::vector<T> kept;
+        kept.reserve(cap);
+        for (std::size_t i = size_ - keep; i < size_; i++) {
+            kept.push_back(std::move(buffer_[(tail_ + i) % cap_]));
+        }
+        kept.resize(cap);
+
+        buffer_ = std::move(kept);
+        cap_ = cap;
+        tail_ = 0;
+        size_ = keep;
+        head_ = keep % cap;
+    }
+
     void reset(std::size_t cap) {
         buffer_.assign(cap, T{});
         cap_ = cap;
@@ -93,6 +221,17 @@ public:
 
 
 private:
+    // Logical index (0 = oldest) of the first element stamped at or after
+    // 'ts_ms'; stamps are kept ascending by MemoryStore::append*
+    std::size_t first_index_not_before(std::int64_t ts_ms) const {
+        std::size_t lo = 0, hi = size_;
+        while (lo < hi) {
+            const std::size_t mid = lo + (hi - lo) / 2;
+            if (buffer_[(tail_ + mid) % cap_].ts_ms < ts_ms) lo = mid + 1; else hi = mid;
+        }
+        return lo;
+    }
+
     std::vector<T> buffer_;
     size_t cap_;
     size_t head_; // next write
@@ -100,6 +239,35 @@ private:
     size_t size_; // current size
 };
 
+// Top-CPU processes at one burst tick
+struct IncidentProcesses {
+    struct Row {
+        int pid = 0;
+        std::string name;
+        double cpu_pct = 0.0;
+    };
+    std::int64_t ts_ms{};
+    std::vector<Row> rows;
+};
+
+// One finished burst capture. Samples stay in typed rings sized for the
+// capture window; /api/incidents serializes them only when asked.
+struct Incident {
+    std::int64_t id{};
+    std::string trigger;                // "cpu", "net_rx", "psi.memory", ...
+    double value = 0.0;
+    double threshold = 0.0;
+    std::int64_t start_ms{};
+    std::int64_t end_ms{};
+    std::int64_t interval_ms{};
+
+    RingBuffer<Sample> cpu_total;
+    RingBuffer<SampleVec> cpu_cores;
+    std::unordered_map<std::string, RingBuffer<Sample>> net_rx;    // by interface
+    std::unordered_map<std::string, RingBuffer<Sample>> net_tx;
+    RingBuffer<IncidentProcesses> processes;
+};
+
 
 class MemoryStore {
 public:
@@ -110,11 +278,25 @@ public:
 
     MemoryStore &operator=(const MemoryStore &) = delete;
 
-    // Append a sample to a metric’s ring (creates ring if missing)
+    // Append a sample to a metric’s ring (creates ring if missing). A stamp
+    // older than the ring's newest (wall clock stepped back) is raised to it,
+    // so every ring stays in ascending stamp order.
     void append(const std::string &metric, std::int64_t ts_ms, double value);
 
     void append_vector(const std::string &metric, std::int64_t ts_ms, std::vector<double> vals);
 
+    // Return and reset the calling thread's append counters (self-telemetry).
+    static AppendStats take_thread_append_stats();
+
+    // Label the rows/columns of a vector series so it can be sliced as a matrix.
+    // Creates the series if missing; call again when the row count changes.
+    // A different shape starts the series over (older samples are dropped),
+    // since they could not be labeled with the new rows and columns.
+    void define_matrix(const std::string &metric, MatrixShape shape);
+
+    // Row/column labels for a matrix series (empty shape if not a matrix).
+    MatrixShape matrix_shape(const std::string &metric) const;
+
     // Query samples in [from_ms, to_ms] for a metric; returns oldest->newest
     std::vector<Sample> query(const std::string &metric,
                               std::int64_t from_ms,
@@ -124,11 +306,62 @@ public:
                                         std::int64_t from_ms,
                                         std::int64_t to_ms) const;
 
+    // Range read reduced by 'spec' (see downsample.h). The kernel walks the
+    // ring in place under the series lock; only the reduced points are copied.
+    std::vector<Sample> query_downsampled(const std::string &metric,
+                                          std::int64_t from_ms,
+                                          std::int64_t to_ms,
+                                          const DownsampleSpec &spec,
+                                          DownsampleInfo *info = nullptr) const;
+
+    std::vector<SampleVec> query_vector_downsampled(const std::string &metric,
+                                                    std::int64_t from_ms,
+                                                    std::int64_t to_ms,
+                                                    const DownsampleSpec &spec,
+                                                    DownsampleInfo *info = nullptr) const;
+
+    // Many reads at once: each series map is locked once to resolve every
+    // selector, then each series is read (and downsampled, if the query asks
+    // for it) under its own lock. Results are in query order; unknown
+    // selectors yield an empty scalar result.
+    std::vector<SeriesResult> query_batch(const std::vector<SeriesQuery> &queries) const;
+
+    // Samples stamped after 'after_ms' (incremental readers such as /api/stream)
+    std::vector<Sample> query_since(const std::string &metric, std::int64_t after_ms) const;
+
+    std::vector<SampleVec> query_vector_since(const std::string &metric, std::int64_t after_ms) const;
+
+    // The newest sample of every non-empty series, scalar series first. Each
+    // series is locked only to copy that one sample.
+    std::vector<LatestSample> latest_samples() const;
+
+    // Stamp of the first sample of 'metric' (vector, else scalar) at or after
+    // 'from_ms'; nullopt if there is none. A range read starting anywhere in
+    // (previous sample, that stamp] returns the same samples.
+    std::optional<std::int64_t> first_sample_ms(const std::string &metric, std::int64_t from_ms) const;
+
     // Count points retained for a metric (0 if unknown)
     std::size_t count(const std::string &metric) const;
 
+    // Samples of 'metric' (vector, else scalar) stamped in [from_ms, to_ms],
+    // found by binary search without copying them
+    std::size_t count_between(const std::string &metric, std::int64_t from_ms, std::int64_t to_ms) const;
+
     // Capacity currently configured per metric (samples)
-    std::size_t capacity_per_metric() const { return per_metric_capacity_; }
+    std::size_t capacity_per_metric() const {
+        std::scoped_lock lk(retention_mtx_);
+        return per_metric_capacity_;
+    }
+
+    // Retention in samples by metric name (selector without labels): its entry
+    // in 'per_metric', else the entry in 'by_label' for the value of the
+    // series' by_label.label when it is of by_label.family, else the entry for
+    // its family (the name up to the first '.', e.g. "fs") in 'per_family',
+    // else 'default_capacity'. Existing rings are resized in place and keep
+    // their newest samples.
+    void set_retention(std::size_t default_capacity, std::unordered_map<std::string, std::size_t> per_metric,
+                       std::unordered_map<std::string, std::size_t> per_family = {},
+                       LabelRetention by_label = {});
 
     void put_snapshot(const std::string &key, const nlohmann::json &j) {
         std::lock_guard<std::mutex> lk(snap_m_);
@@ -141,6 +374,13 @@ public:
         return it == snapshots_.end() ? nlohmann::json() : it->second;
     }
 
+    // Row tables with generations and deltas (see versioned_table.h), e.g.
+    // "processes" keyed by pid. Returns the table's generation.
+    std::uint64_t put_table(const std::string &key, nlohmann::json rows, const std::string &id_field);
+
+    // Delta since 'since' or the full table; generation 0 for an unknown key.
+    TableRead read_table(const std::string &key, std::uint64_t since) const;
+
     bool vec_series_exists(const std::string& key) const {
         std::scoped_lock lk(vec_mtx_);
         return vec_series_.find(key) != vec_series_.end();
@@ -158,12 +398,65 @@ public:
 
     std::vector<std::string> list_series_keys() const;
 
+    // Answered from the label index (see label_index.h) without visiting
+    // every series key: metrics by name prefix with their label values, the
+    // values of one label, and the series carrying one label value.
+    std::vector<MetricLabels> stored_metrics(const std::string &prefix = {}) const;
+
+    std::vector<std::string> label_values(const std::string &metric, const std::string &label) const;
+
+    std::vector<std::string> series_with_label(const std::string &metric, const std::string &label,
+                                               const std::string &value) const;
+
+    std::size_t series_count() const;
+
+    // Drop every series of the metrics named 'prefix'* that carries
+    // label=value (e.g. all "cgroup." series of a removed cgroup) from the
+    // maps and the label index. A reader still holding one finishes with it;
+    // its ring is freed after that. A later append starts a new series.
+    // Returns the number retired.
+    std::size_t retire_series(const std::string &prefix, const std::string &label, const std::string &value);
+
     void put_metadata(const std::string &key, const nlohmann::json &value);
 
     nlohmann::json get_metadata(const std::string &key) const;
 
     nlohmann::json all_metadata() const;
 
+    // The sampler calls commit() once a task's samples are all appended;
+    // each call bumps the commit generation and wakes wait_for_commit().
+    // 'new_samples' is false for runs that stored nothing of their own (such
+    // as "config"); those never move the tick generation.
+    void commit(bool new_samples = true);
+
+    std::uint64_t commit_generation() const;
+
+    // Moves at most once per tick period, on its first commit with new
+    // samples. Readers that rebuild whole responses (the query cache,
+    // /metrics) follow this instead of every task's commit.
+    std::uint64_t tick_generation() const;
+
+    // Length of the tick behind tick_generation(); the sampler keeps it at
+    // the fast lane's period (default SAMPLE_PERIOD_S).
+    void set_tick_period_ms(std::int64_t period_ms);
+
+    // Wall-clock time of the last commit(); every sample committed so far is
+    // stamped at or before it.
+    std::int64_t last_commit_ms() const;
+
+    // Block until the generation differs from 'seen' or 'timeout' passes;
+    // returns the generation at wake-up.
+    std::uint64_t wait_for_commit(std::uint64_t seen, std::chrono::milliseconds timeout) const;
+
+    // As wait_for_commit(), for the tick generation
+    std::uint64_t wait_for_tick(std::uint64_t seen, std::chrono::milliseconds timeout) const;
+
+    // Finished burst captures, oldest first; the oldest is dropped once
+    // 'max_incidents' are held.
+    void put_incident(std::shared_ptr<const Incident> incident, std::size_t max_incidents);
+
+    std::vector<std::shared_ptr<const Incident>> incidents() const;
+
 
 private:
     struct Series {
@@ -175,32 +468,58 @@ private:
     struct VecSeries {
         explicit VecSeries(std::size_t cap) : ring(cap) {}
         RingBuffer<SampleVec> ring;
+        MatrixShape shape;      // guarded by vec_mtx_
         mutable std::mutex mtx; // guards ring
     };
 
 
-    // Lazily creates a series if not exists (non-const)
-    Series &ensure_series_(const std::string &metric);
+    // Ring capacity for a selector under the current retention settings
+    std::size_t capacity_for_(const std::string &metric) const;
+
+    // Record a new series in index_; callers hold map_mtx_ or vec_mtx_
+    void index_series_(const std::string &selector, SeriesKind kind);
 
     // Returns pointer if exists, else nullptr (const)
-    const Series *find_series_(const std::string &metric) const;
+    std::shared_ptr<const Series> find_series_(const std::string &metric) const;
 
+    mutable std::mutex retention_mtx_; // guards the four capacity fields below
     std::size_t per_metric_capacity_;
+    std::unordered_map<std::string, std::size_t> metric_capacity_;
+    std::unordered_map<std::string, std::size_t> family_capacity_;
+    LabelRetention label_capacity_;
     std::size_t sample_period_s_;
 
 
     mutable std::mutex map_mtx_;
-    std::unordered_map<std::string, Series> series_;
+    std::unordered_map<std::string, std::shared_ptr<Series>> series_;
 
     mutable std::mutex vec_mtx_;
-    std::unordered_map<std::string, VecSeries> vec_series_;
+    std::unordered_map<std::string, std::shared_ptr<VecSeries>> vec_series_;
+
+    // Taken after map_mtx_ / vec_mtx_ when a series is created or retired, never before
+    mutable std::mutex index_mtx_;
+    LabelIndex index_;
 
     mutable std::mutex snap_m_;
     std::unordered_map<std::string, nlohmann::json> snapshots_;
 
+    mutable std::mutex table_mtx_;
+    std::unordered_map<std::string, VersionedTable> tables_;
+
     mutable std::mutex meta_mtx_;
     std::unordered_map<std::string, nlohmann::json> metadata_;
 
+    mutable std::mutex incident_mtx_;
+    std::deque<std::shared_ptr<const Incident>> incidents_;
+
+    mutable std::mutex commit_mtx_;
+    mutable std::condition_variable commit_cv_;
+    std::uint64_t commit_generation_ = 0;
+    std::uint64_t tick_generation_ = 0;
+    std::int64_t tick_period_ms_;
+    std::int64_t tick_period_index_ = -1;   // tick period of the last tick
+    std::int64_t last_commit_ms_ = 0;
+
 };
 
 #endif //SYSTEM_MONITORING_DASHBOARD_MEMORY_STORE_H
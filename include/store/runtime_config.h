@@ -0,0 +1,61 @@
+//
+// runtime_config.h — settings that can change while the daemon runs.
+//
+// Read from a JSON file (CONFIG_FILE, default ./dashboard.json) at startup and
+// again on SIGHUP. Anything the file leaves out keeps its built-in / env
+// default from config.h. Example:
+//
+//   {
+//     "periods_ms": {"process": 2000, "filesystem": 60000},
+//     "retention_s": {"default": 3600, "cpu.core_pct": 600, "fs.used": 86400},
+//     "limits": {"process_table": 64, "cgroup_max_depth": 3, "cgroup_max_series": 128},
+//     "disk": {"aggregate_partitions": false}
+//   }
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_RUNTIME_CONFIG_H
+#define SYSTEM_MONITORING_DASHBOARD_RUNTIME_CONFIG_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "store/memory_store.h"
+
+struct RuntimeConfig {
+    std::string path;                                          // file loaded ("" = defaults only)
+    std::unordered_map<std::string, int64_t> periods_ms;       // collector task -> period
+    std::size_t retention_s = 0;                               // every series without an override
+    std::unordered_map<std::string, std::size_t> metric_retention_s;  // metric name -> seconds
+                                                               // (samples = seconds / producing task's period)
+    std::size_t process_table_limit = 128;
+    int cgroup_max_depth = 2;
+    int cgroup_max_series = 64;
+    bool disk_aggregate_partitions = true;
+
+    // Period for 'task', or 'fallback_ms' when the file does not set one.
+    int64_t period_ms(const std::string& task, int64_t fallback_ms) const;
+};
+
+// Current settings; the pointer stays valid for as long as the caller holds it.
+std::shared_ptr<const RuntimeConfig> runtime_config();
+
+// (Re)read the config file. A missing file means defaults. On a parse error
+// the current settings are kept, 'error' is filled and false is returned.
+bool load_runtime_config(std::string& error);
+
+// Async-signal-safe: ask for a reload (SIGHUP handler).
+void request_config_reload();
+
+// true once per pending reload request.
+bool take_config_reload_request();
+
+// Resize every ring to the configured retention, keeping recent samples.
+// Seconds become samples using the configured period of the collector task
+// that produces each metric (filesystem series at 30 s keep 1/30 as many).
+void apply_retention(MemoryStore& store, const RuntimeConfig& config);
+
+#endif //SYSTEM_MONITORING_DASHBOARD_RUNTIME_CONFIG_H
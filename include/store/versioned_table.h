@@ -0,0 +1,63 @@
+//
+// versioned_table.h — a row table (e.g. the process list) with generations
+// and row/field deltas between them.
+//
+
+#ifndef SYSTEM_MONITORING_DASHBOARD_VERSIONED_TABLE_H
+#define SYSTEM_MONITORING_DASHBOARD_VERSIONED_TABLE_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+
+#include "third_party/json.hpp"
+
+// Tables published this many generations ago can still be diffed against
+constexpr std::size_t kTableHistory = 8;
+
+// Result of VersionedTable::read(). Either the full 'rows' (is_delta false),
+// or what changed since the reader's generation:
+//   added   rows that are new
+//   removed ids that are gone
+//   changed {id_field: id, field: value, ...} with only the fields that differ
+struct TableRead {
+    std::uint64_t generation = 0;
+    bool is_delta = false;
+    nlohmann::json rows = nlohmann::json::array();
+    nlohmann::json added = nlohmann::json::array();
+    nlohmann::json removed = nlohmann::json::array();
+    nlohmann::json changed = nlohmann::json::array();
+};
+
+// Not thread-safe; MemoryStore guards its tables. Generations start at the
+// creation time in ms and count up by one per change, so a generation a
+// client kept from before a restart is never mistaken for a current one.
+class VersionedTable {
+public:
+    explicit VersionedTable(std::string id_field);
+
+    // Replace the rows (an array of objects carrying id_field). The generation
+    // only moves when they differ from the current ones. Returns it.
+    std::uint64_t publish(nlohmann::json rows);
+
+    std::uint64_t generation() const { return generation_; }
+
+    // Delta from 'since' when that generation is still held (an empty delta
+    // when it is current), the full table otherwise (since 0, too old, or
+    // from the future after a restart).
+    TableRead read(std::uint64_t since) const;
+
+private:
+    TableRead diff(const nlohmann::json& before, const nlohmann::json& after) const;
+
+    std::string id_field_;
+    std::uint64_t generation_ = 0;
+    std::deque<std::pair<std::uint64_t, nlohmann::json>> history_;  // oldest first, current last
+    TableRead last_delta_;  // previous generation -> current, the common case
+};
+
+#endif //SYSTEM_MONITORING_DASHBOARD_VERSIONED_TABLE_H
@@ -1,13 +1,19 @@
 #include <atomic>
+#include <csignal>
+#include <iostream>
 #include <thread>
 #include <cstdlib>
 #include <string>
 #include <fstream>
 
+#include "api/prometheus.h"
+#include "api/response_cache.h"
 #include "api/routes.h"
+#include "api/stream.h"
 #include "collector/loop.h"
 #include "config.h"
 #include "store/memory_store.h"
+#include "store/runtime_config.h"
 #include "store/system_info.h"
 #include "third_party/httplib.h"
 
@@ -100,16 +106,38 @@ namespace {
  */
 int main() {
     std::atomic<bool> sampler_running(true);
+
+    // Runtime config file; SIGHUP re-reads it (picked up by the sampler)
+    if (std::string config_error; !load_runtime_config(config_error)) {
+        std::cerr << "config: " << config_error << " (using defaults)\n";
+    }
+    std::signal(SIGHUP, [](int) { request_config_reload(); });
+
     MemoryStore store(cfg::KEEP_SECONDS, cfg::SAMPLE_PERIOD_S);
+    apply_retention(store, *runtime_config());
 
     cache_system_metadata(store);
 
     std::thread sampler_thread = start_sampler(store, sampler_running);
 
+    // Pushes each committed tick to /api/stream clients
+    StreamHub stream_hub(store, cfg::STREAM_MAX_CLIENTS);
+
+    // Identical /api/query requests within one tick share a response
+    ResponseCache query_cache(store, std::size_t(cfg::QUERY_CACHE_MB) << 20);
+
+    // /metrics exposition, re-rendered after each tick
+    PrometheusExporter prometheus(store);
+
     httplib::Server server;
 
+    // Every stream client holds a worker for as long as it stays connected
+    server.new_task_queue = [] {
+        return new httplib::ThreadPool(CPPHTTPLIB_THREAD_POOL_COUNT + size_t(cfg::STREAM_MAX_CLIENTS));
+    };
+
     // Bind API routes (e.g. /api/status, /api/stored, etc.)
-    bind_routes(server, store);
+    bind_routes(server, store, stream_hub, query_cache, prometheus);
 
     // Bind static frontend (web UI)
     const std::string web_root = resolve_web_root();
@@ -0,0 +1,304 @@
+//
+// downsample.cpp — LTTB and bucket kernels over RingSpans.
+//
+// The kernels read the ring in place (a 2-hour range is walked once, under
+// the series lock, and only the reduced points are copied out). Bucket edges
+// are found by binary search; each bucket is then reduced run by run with
+// plain loops over contiguous memory. The scalar reduction keeps four
+// independent accumulators so it is not serialised on one add/compare chain
+// and vectorises without -ffast-math; the vector-series kernel works on whole
+// rows of doubles.
+//
+#include "store/downsample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "store/memory_store.h"
+
+namespace {
+
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+// LTTB needs the two end points plus at least one bucket in between
+constexpr std::size_t kMinLttbPoints = 3;
+
+struct Reduction {
+    double sum = 0.0;
+    double min = kInf;
+    double max = -kInf;
+    std::size_t count = 0;
+};
+
+void reduce_run(const Sample* p, std::size_t n, Reduction& r) {
+    double sum[4] = {0.0, 0.0, 0.0, 0.0};
+    double lo[4] = {kInf, kInf, kInf, kInf};
+    double hi[4] = {-kInf, -kInf, -kInf, -kInf};
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (std::size_t k = 0; k < 4; ++k) {
+            const double v = p[i + k].value;
+            sum[k] += v;
+            lo[k] = v < lo[k] ? v : lo[k];
+            hi[k] = v > hi[k] ? v : hi[k];
+        }
+    }
+    for (; i < n; ++i) {
+        const double v = p[i].value;
+        sum[0] += v;
+        lo[0] = v < lo[0] ? v : lo[0];
+        hi[0] = v > hi[0] ? v : hi[0];
+    }
+
+    r.sum += (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    r.min = std::min({r.min, lo[0], lo[1], lo[2], lo[3]});
+    r.max = std::max({r.max, hi[0], hi[1], hi[2], hi[3]});
+    r.count += n;
+}
+
+std::int64_t align_down(std::int64_t ts, std::int64_t step) {
+    const std::int64_t rem = ts % step;
+    return rem < 0 ? ts - rem - step : ts - rem;
+}
+
+// First index in [lo, size) stamped at or after 'ts'
+template<typename T>
+std::size_t first_at_or_after(const RingSpans<T>& in, std::size_t lo, std::int64_t ts) {
+    std::size_t hi = in.size();
+    while (lo < hi) {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        if (in[mid].ts_ms < ts) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+template<typename T>
+void copy_raw(const RingSpans<T>& in, std::vector<T>& out) {
+    out.reserve(in.size());
+    in.for_each_run(0, in.size(), [&](const T* p, std::size_t n, std::size_t) {
+        out.insert(out.end(), p, p + n);
+    });
+}
+
+struct Plan {
+    DownsampleAgg agg = DownsampleAgg::kNone;
+    std::int64_t step_ms = 0;
+    std::size_t points = 0;     // LTTB threshold
+};
+
+// Turn the request into a step (and LTTB point count) for this range, or
+// kNone when the raw range is no larger than the result would be.
+Plan plan_for(std::size_t n, std::int64_t first_ts, std::int64_t last_ts, const DownsampleSpec& spec,
+              bool scalar) {
+    Plan plan;
+    DownsampleAgg agg = spec.agg;
+    if (!scalar && (agg == DownsampleAgg::kLttb || agg == DownsampleAgg::kMinMax)) agg = DownsampleAgg::kAvg;
+    if (agg == DownsampleAgg::kNone || n < kMinLttbPoints) return plan;
+
+    const std::int64_t span = std::max<std::int64_t>(1, last_ts - first_ts + 1);
+    const std::size_t per_bucket = agg == DownsampleAgg::kMinMax ? 2 : 1;
+
+    std::int64_t step = std::max<std::int64_t>(0, spec.step_ms);
+    if (spec.max_points > 0) {
+        const auto buckets = std::int64_t(std::max<std::size_t>(1, spec.max_points / per_bucket));
+        step = std::max(step, (span + buckets - 1) / buckets);
+    }
+    if (step <= 0) return plan;
+
+    // Aligned buckets can straddle one extra boundary
+    const std::size_t points = (std::size_t((span + step - 1) / step) + 1) * per_bucket;
+    if (points >= n) return plan;
+
+    plan.agg = agg;
+    plan.step_ms = step;
+    plan.points = std::max(kMinLttbPoints, std::size_t((span + step - 1) / step));
+    return plan;
+}
+
+void bucket_scalar(const RingSpans<Sample>& in, std::int64_t step, DownsampleAgg agg, std::vector<Sample>& out) {
+    const std::size_t n = in.size();
+    for (std::size_t i = 0; i < n;) {
+        const std::int64_t start = align_down(in[i].ts_ms, step);
+        const std::size_t end = first_at_or_after(in, i + 1, start + step);
+
+        Reduction r;
+        in.for_each_run(i, end, [&r](const Sample* p, std::size_t m, std::size_t) { reduce_run(p, m, r); });
+
+        switch (agg) {
+            case DownsampleAgg::kMin:
+                out.push_back({start, r.min});
+                break;
+            case DownsampleAgg::kMax:
+                out.push_back({start, r.max});
+                break;
+            case DownsampleAgg::kMinMax: {
+                // The extreme samples at their own timestamps, in time order
+                std::size_t lo_at = end, hi_at = end;
+                for (std::size_t k = i; k < end && (lo_at == end || hi_at == end); ++k) {
+                    if (lo_at == end && in[k].value == r.min) lo_at = k;
+                    if (hi_at == end && in[k].value == r.max) hi_at = k;
+                }
+                out.push_back(in[std::min(lo_at, hi_at)]);
+                if (lo_at != hi_at) out.push_back(in[std::max(lo_at, hi_at)]);
+                break;
+            }
+            default:
+                out.push_back({start, r.sum / double(r.count)});
+                break;
+        }
+        i = end;
+    }
+}
+
+// Sveinn Steinarsson's LTTB: keep the first and last samples, and from each
+// of the threshold-2 buckets in between the sample forming the largest
+// triangle with the previously kept one and the next bucket's average.
+void lttb(const RingSpans<Sample>& in, std::size_t threshold, std::vector<Sample>& out) {
+    const std::size_t n = in.size();
+    const double every = double(n - 2) / double(threshold - 2);
+    out.reserve(threshold);
+    out.push_back(in[0]);
+
+    std::size_t kept = 0;
+    for (std::size_t b = 0; b + 2 < threshold; ++b) {
+        const std::size_t lo = std::size_t(double(b) * every) + 1;
+        const std::size_t hi = std::min(std::size_t(double(b + 1) * every) + 1, n - 1);
+        const std::size_t next_hi = std::min(std::size_t(double(b + 2) * every) + 1, n);
+
+        // x is relative to the kept sample so int64 timestamps stay exact in doubles
+        const std::int64_t origin = in[kept].ts_ms;
+        const double ay = in[kept].value;
+
+        double sum_x = 0.0, sum_y = 0.0;
+        in.for_each_run(hi, next_hi, [&](const Sample* p, std::size_t m, std::size_t) {
+            for (std::size_t k = 0; k < m; ++k) {
+                sum_x += double(p[k].ts_ms - origin);
+                sum_y += p[k].value;
+            }
+        });
+        const double count = double(std::max<std::size_t>(1, next_hi - hi));
+        const double cx = sum_x / count;
+        const double cy = sum_y / count;
+
+        double best_area = -1.0;
+        std::size_t best_at = lo;
+        in.for_each_run(lo, std::max(lo + 1, hi), [&](const Sample* p, std::size_t m, std::size_t offset) {
+            for (std::size_t k = 0; k < m; ++k) {
+                const double bx = double(p[k].ts_ms - origin);
+                const double area = std::fabs(bx * (cy - ay) - cx * (p[k].value - ay));
+                if (area > best_area) {
+                    best_area = area;
+                    best_at = offset + k;
+                }
+            }
+        });
+
+        out.push_back(in[best_at]);
+        kept = best_at;
+    }
+    out.push_back(in[n - 1]);
+}
+
+void bucket_vector(const RingSpans<SampleVec>& in, std::int64_t step, DownsampleAgg agg,
+                   std::vector<SampleVec>& out) {
+    const std::size_t n = in.size();
+    std::vector<double> acc;
+    for (std::size_t i = 0; i < n;) {
+        const std::int64_t start = align_down(in[i].ts_ms, step);
+        const std::size_t end = first_at_or_after(in, i + 1, start + step);
+
+        // Rows of another width (core count changed) are left out of the bucket
+        const std::size_t width = in[i].vals.size();
+        const double init = agg == DownsampleAgg::kMin ? kInf : agg == DownsampleAgg::kMax ? -kInf : 0.0;
+        acc.assign(width, init);
+        std::size_t rows = 0;
+
+        in.for_each_run(i, end, [&](const SampleVec* p, std::size_t m, std::size_t) {
+            for (std::size_t k = 0; k < m; ++k) {
+                if (p[k].vals.size() != width) continue;
+                const double* v = p[k].vals.data();
+                double* a = acc.data();
+                if (agg == DownsampleAgg::kMin) {
+                    for (std::size_t c = 0; c < width; ++c) a[c] = v[c] < a[c] ? v[c] : a[c];
+                } else if (agg == DownsampleAgg::kMax) {
+                    for (std::size_t c = 0; c < width; ++c) a[c] = v[c] > a[c] ? v[c] : a[c];
+                } else {
+                    for (std::size_t c = 0; c < width; ++c) a[c] += v[c];
+                }
+                rows++;
+            }
+        });
+
+        if (agg != DownsampleAgg::kMin && agg != DownsampleAgg::kMax) {
+            for (double& a : acc) a /= double(rows);
+        }
+        out.push_back(SampleVec{start, acc});
+        i = end;
+    }
+}
+
+} // namespace
+
+bool parse_downsample_agg(const std::string& name, DownsampleAgg& agg) {
+    if (name == "lttb") agg = DownsampleAgg::kLttb;
+    else if (name == "minmax") agg = DownsampleAgg::kMinMax;
+    else if (name == "avg") agg = DownsampleAgg::kAvg;
+    else if (name == "min") agg = DownsampleAgg::kMin;
+    else if (name == "max") agg = DownsampleAgg::kMax;
+    else if (name == "raw") agg = DownsampleAgg::kNone;
+    else return false;
+    return true;
+}
+
+const char* downsample_agg_name(DownsampleAgg agg) {
+    switch (agg) {
+        case DownsampleAgg::kLttb: return "lttb";
+        case DownsampleAgg::kMinMax: return "minmax";
+        case DownsampleAgg::kAvg: return "avg";
+        case DownsampleAgg::kMin: return "min";
+        case DownsampleAgg::kMax: return "max";
+        default: return "raw";
+    }
+}
+
+DownsampleInfo downsample(const RingSpans<Sample>& in, const DownsampleSpec& spec, std::vector<Sample>& out) {
+    DownsampleInfo info;
+    info.source_points = in.size();
+    out.clear();
+
+    const std::size_t n = in.size();
+    const Plan plan = n ? plan_for(n, in[0].ts_ms, in[n - 1].ts_ms, spec, true) : Plan{};
+    if (plan.agg == DownsampleAgg::kNone) {
+        copy_raw(in, out);
+        return info;
+    }
+
+    info.agg = plan.agg;
+    info.step_ms = plan.step_ms;
+    if (plan.agg == DownsampleAgg::kLttb) {
+        lttb(in, plan.points, out);
+    } else {
+        bucket_scalar(in, plan.step_ms, plan.agg, out);
+    }
+    return info;
+}
+
+DownsampleInfo downsample(const RingSpans<SampleVec>& in, const DownsampleSpec& spec, std::vector<SampleVec>& out) {
+    DownsampleInfo info;
+    info.source_points = in.size();
+    out.clear();
+
+    const std::size_t n = in.size();
+    const Plan plan = n ? plan_for(n, in[0].ts_ms, in[n - 1].ts_ms, spec, false) : Plan{};
+    if (plan.agg == DownsampleAgg::kNone) {
+        copy_raw(in, out);
+        return info;
+    }
+
+    info.agg = plan.agg;
+    info.step_ms = plan.step_ms;
+    bucket_vector(in, plan.step_ms, plan.agg, out);
+    return info;
+}
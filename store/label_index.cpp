@@ -0,0 +1,115 @@
+//
+// label_index.cpp — postings per metric label value.
+//
+// Ordered maps keep metric names and label values sorted as they are
+// inserted, so listings and prefix scans need no per-request sort.
+//
+#include "store/label_index.h"
+
+#include <algorithm>
+
+#include "metrics/metric_key.h"
+
+const char* series_kind_name(SeriesKind kind) {
+    switch (kind) {
+        case SeriesKind::kVector: return "vector";
+        case SeriesKind::kMatrix: return "matrix";
+        default: return "scalar";
+    }
+}
+
+LabelIndex::SeriesId LabelIndex::add(const std::string& selector, SeriesKind kind) {
+    SeriesId id;
+    if (free_ids_.empty()) {
+        id = static_cast<SeriesId>(selectors_.size());
+        selectors_.push_back(selector);
+    } else {
+        id = free_ids_.back();
+        free_ids_.pop_back();
+        selectors_[id] = selector;
+    }
+    ids_[selector] = id;
+
+    MetricSelectorParts parts = parse_selector(selector);
+    Metric& metric = metrics_[parts.metric];
+    metric.kind = std::max(metric.kind, kind);
+    metric.series++;
+    for (const auto& [label, value] : parts.labels) metric.postings[label][value].push_back(id);
+    return id;
+}
+
+bool LabelIndex::remove(const std::string& selector) {
+    const auto found = ids_.find(selector);
+    if (found == ids_.end()) return false;
+    const SeriesId id = found->second;
+    ids_.erase(found);
+    selectors_[id].clear();
+    free_ids_.push_back(id);
+
+    MetricSelectorParts parts = parse_selector(selector);
+    const auto metric = metrics_.find(parts.metric);
+    if (metric == metrics_.end()) return true;
+    auto& postings = metric->second.postings;
+    for (const auto& [label, value] : parts.labels) {
+        const auto values = postings.find(label);
+        if (values == postings.end()) continue;
+        const auto ids = values->second.find(value);
+        if (ids == values->second.end()) continue;
+
+        ids->second.erase(std::remove(ids->second.begin(), ids->second.end(), id), ids->second.end());
+        if (ids->second.empty()) values->second.erase(ids);
+        if (values->second.empty()) postings.erase(values);
+    }
+    if (--metric->second.series == 0) metrics_.erase(metric);
+    return true;
+}
+
+void LabelIndex::set_kind(const std::string& selector, SeriesKind kind) {
+    auto it = metrics_.find(parse_selector(selector).metric);
+    if (it != metrics_.end()) it->second.kind = std::max(it->second.kind, kind);
+}
+
+std::vector<MetricLabels> LabelIndex::metrics(const std::string& prefix) const {
+    std::vector<MetricLabels> out;
+    for (auto it = metrics_.lower_bound(prefix);
+         it != metrics_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        MetricLabels entry;
+        entry.name = it->first;
+        entry.kind = it->second.kind;
+        entry.series = it->second.series;
+        for (const auto& [label, values] : it->second.postings) {
+            auto& names = entry.labels[label];
+            names.reserve(values.size());
+            for (const auto& value : values) names.push_back(value.first);
+        }
+        out.push_back(std::move(entry));
+    }
+    return out;
+}
+
+std::vector<std::string> LabelIndex::label_values(const std::string& metric, const std::string& label) const {
+    std::vector<std::string> out;
+    const auto it = metrics_.find(metric);
+    if (it == metrics_.end()) return out;
+    const auto values = it->second.postings.find(label);
+    if (values == it->second.postings.end()) return out;
+
+    out.reserve(values->second.size());
+    for (const auto& value : values->second) out.push_back(value.first);
+    return out;
+}
+
+std::vector<std::string> LabelIndex::series(const std::string& metric, const std::string& label,
+                                            const std::string& value) const {
+    std::vector<std::string> out;
+    const auto it = metrics_.find(metric);
+    if (it == metrics_.end()) return out;
+    const auto values = it->second.postings.find(label);
+    if (values == it->second.postings.end()) return out;
+    const auto ids = values->second.find(value);
+    if (ids == values->second.end()) return out;
+
+    out.reserve(ids->second.size());
+    for (const SeriesId id : ids->second) out.push_back(selectors_[id]);
+    return out;
+}
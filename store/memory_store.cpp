@@ -10,7 +10,7 @@
 // Concurrency notes:
 // - Lock order is consistent and minimal: we briefly lock map_mtx_ to find or create
 //   the series, release it, then lock the Series::mtx to operate on its ring.
-// - Series is constructed in-place using try_emplace(metric, per_metric_capacity_)
+// - Series is constructed in-place using try_emplace(metric, capacity_for_(metric))
 //   to avoid copying/moving (e.g., std::mutex cannot be moved/copied).
 //
 // Complexity notes (amortized):
@@ -19,9 +19,33 @@
 // - count: O(1).
 //
 #include "store/memory_store.h"
+#include "config.h"
+#include "metrics/metric_key.h"
+#include "metrics/time.h"
 #include <algorithm>   // std::max
+#include <chrono>
 #include <utility>     // std::move
 
+namespace {
+
+thread_local AppendStats t_append_stats;
+
+// Charges the enclosing append to the calling thread's AppendStats.
+class AppendTimer {
+public:
+    AppendTimer() : start_(std::chrono::steady_clock::now()) {}
+    ~AppendTimer() {
+        t_append_stats.appends++;
+        t_append_stats.elapsed_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace
+
 /**
  * Compute the per-metric capacity based on how many seconds to keep and the sampling period.
  * We clamp both 'keep_seconds' and 'sample_period_s' to at least 1 to avoid division by zero
@@ -34,6 +58,65 @@ MemoryStore::MemoryStore(std::size_t keep_seconds, std::size_t sample_period_s)
     );
     // Store the effective sample period (also clamped to >= 1).
     sample_period_s_ = std::max<std::size_t>(1, sample_period_s);
+    tick_period_ms_ = std::int64_t(sample_period_s_) * 1000;
+}
+
+std::size_t MemoryStore::capacity_for_(const std::string &metric) const {
+    const std::string name = metric.substr(0, metric.find('{'));
+    std::scoped_lock lk(retention_mtx_);
+    auto it = metric_capacity_.find(name);
+    if (it != metric_capacity_.end()) return it->second;
+
+    const std::string family = name.substr(0, name.find('.'));
+    if (!label_capacity_.by_value.empty() && family == label_capacity_.family) {
+        const auto labels = parse_selector(metric).labels;
+        const auto label = labels.find(label_capacity_.label);
+        if (label != labels.end()) {
+            it = label_capacity_.by_value.find(label->second);
+            if (it != label_capacity_.by_value.end()) return it->second;
+        }
+    }
+
+    it = family_capacity_.find(family);
+    return it == family_capacity_.end() ? per_metric_capacity_ : it->second;
+}
+
+/**
+ * Switch to new retention settings. New series pick them up on creation;
+ * existing rings are resized in place (newest samples kept) while the map
+ * lock is held, each under its own series lock.
+ */
+void MemoryStore::set_retention(std::size_t default_capacity,
+                                std::unordered_map<std::string, std::size_t> per_metric,
+                                std::unordered_map<std::string, std::size_t> per_family,
+                                LabelRetention by_label) {
+    {
+        std::scoped_lock lk(retention_mtx_);
+        per_metric_capacity_ = std::max<std::size_t>(1, default_capacity);
+        for (auto& [name, cap] : per_metric) cap = std::max<std::size_t>(1, cap);
+        for (auto& [family, cap] : per_family) cap = std::max<std::size_t>(1, cap);
+        for (auto& [value, cap] : by_label.by_value) cap = std::max<std::size_t>(1, cap);
+        metric_capacity_ = std::move(per_metric);
+        family_capacity_ = std::move(per_family);
+        label_capacity_ = std::move(by_label);
+    }
+
+    {
+        std::scoped_lock lk(map_mtx_);
+        for (auto& [metric, s] : series_) {
+            const std::size_t cap = capacity_for_(metric);
+            std::scoped_lock ls(s->mtx);
+            s->ring.resize(cap);
+        }
+    }
+    {
+        std::scoped_lock lk(vec_mtx_);
+        for (auto& [metric, vs] : vec_series_) {
+            const std::size_t cap = capacity_for_(metric);
+            std::scoped_lock ls(vs->mtx);
+            vs->ring.resize(cap);
+        }
+    }
 }
 
 /**
@@ -45,23 +128,28 @@ MemoryStore::MemoryStore(std::size_t keep_seconds, std::size_t sample_period_s)
  * - Locks the specific Series only while appending to its ring.
  */
 void MemoryStore::append(const std::string &metric, std::int64_t ts_ms, double value) {
-    Series* s = nullptr;
+    AppendTimer timer;
+    std::shared_ptr<Series> s;
 
     // Acquire map lock to find or create the Series entry.
     {
         std::scoped_lock lk(map_mtx_);
 
-        // try_emplace constructs the mapped value in place if missing.
-        // Arguments: (key, Series constructor args...)
-        // Here Series(capacity) is constructed directly, avoiding copies/moves.
-        auto [it, inserted] = series_.try_emplace(metric, per_metric_capacity_);
-        (void)inserted; // not needed further; creation is idempotent for our purposes
-        s = &it->second;
+        // The capacity lookup only runs for new series.
+        auto it = series_.find(metric);
+        if (it == series_.end()) {
+            it = series_.try_emplace(metric, std::make_shared<Series>(capacity_for_(metric))).first;
+            index_series_(metric, SeriesKind::kScalar);
+        }
+        s = it->second;
     }
 
-    // At this point, 's' points to a valid Series. Lock the series and append.
+    // 's' stays valid even if the series is retired meanwhile. Lock it and append.
     {
         std::scoped_lock lk(s->mtx);
+        // Reads binary-search by stamp, so a wall clock stepped back (NTP)
+        // must not make a ring run backwards: hold the stamp at the newest.
+        if (const Sample* newest = s->ring.newest(); newest && ts_ms < newest->ts_ms) ts_ms = newest->ts_ms;
         // RingBuffer::append overwrites the oldest element when full.
         s->ring.append(Sample{ts_ms, value});
     }
@@ -69,23 +157,119 @@ void MemoryStore::append(const std::string &metric, std::int64_t ts_ms, double v
 
 
 void MemoryStore::append_vector(const std::string& metric, int64_t ts_ms, std::vector<double> vals) {
+    AppendTimer timer;
     // Access or create vector series
-    VecSeries* vs = nullptr;
+    std::shared_ptr<VecSeries> vs;
 
     {
         std::scoped_lock lk(vec_mtx_);
-        auto[it, inserted] = vec_series_.try_emplace(metric, per_metric_capacity_);
-        vs = &it->second;
+        auto it = vec_series_.find(metric);
+        if (it == vec_series_.end()) {
+            it = vec_series_.try_emplace(metric, std::make_shared<VecSeries>(capacity_for_(metric))).first;
+            index_series_(metric, SeriesKind::kVector);
+        }
+        vs = it->second;
     }
 
     // Append under the series lock
     {
         std::scoped_lock lk(vs->mtx);
+        if (const SampleVec* newest = vs->ring.newest(); newest && ts_ms < newest->ts_ms) ts_ms = newest->ts_ms;
         vs->ring.append(SampleVec{ts_ms, std::move(vals)});
     }
 }
 
 
+AppendStats MemoryStore::take_thread_append_stats() {
+    AppendStats stats = t_append_stats;
+    t_append_stats = AppendStats{};
+    return stats;
+}
+
+void MemoryStore::define_matrix(const std::string& metric, MatrixShape shape) {
+    std::scoped_lock lk(vec_mtx_);
+    auto [it, inserted] = vec_series_.try_emplace(metric, nullptr);
+    if (!inserted && it->second->shape == shape) return;
+
+    // A new shape gets a fresh ring; readers still holding the old series
+    // keep its samples and shape
+    it->second = std::make_shared<VecSeries>(capacity_for_(metric));
+    it->second->shape = std::move(shape);
+    if (inserted) {
+        index_series_(metric, SeriesKind::kMatrix);
+    } else {
+        std::scoped_lock li(index_mtx_);
+        index_.set_kind(metric, SeriesKind::kMatrix);
+    }
+}
+
+void MemoryStore::index_series_(const std::string& selector, SeriesKind kind) {
+    std::scoped_lock li(index_mtx_);
+    index_.add(selector, kind);
+}
+
+std::vector<MetricLabels> MemoryStore::stored_metrics(const std::string& prefix) const {
+    std::scoped_lock li(index_mtx_);
+    return index_.metrics(prefix);
+}
+
+std::vector<std::string> MemoryStore::label_values(const std::string& metric, const std::string& label) const {
+    std::scoped_lock li(index_mtx_);
+    return index_.label_values(metric, label);
+}
+
+std::vector<std::string> MemoryStore::series_with_label(const std::string& metric, const std::string& label,
+                                                        const std::string& value) const {
+    std::scoped_lock li(index_mtx_);
+    return index_.series(metric, label, value);
+}
+
+std::size_t MemoryStore::series_count() const {
+    std::scoped_lock li(index_mtx_);
+    return index_.size();
+}
+
+std::size_t MemoryStore::retire_series(const std::string& prefix, const std::string& label,
+                                       const std::string& value) {
+    std::vector<std::string> selectors;
+    {
+        std::scoped_lock li(index_mtx_);
+        for (const MetricLabels& metric : index_.metrics(prefix)) {
+            for (std::string& selector : index_.series(metric.name, label, value)) {
+                selectors.push_back(std::move(selector));
+            }
+        }
+    }
+
+    // Erase and unindex under the map lock, so a concurrent append either
+    // lands in the old series or creates and indexes a new one
+    std::size_t retired = 0;
+    {
+        std::scoped_lock lk(map_mtx_);
+        for (const std::string& selector : selectors) {
+            if (series_.erase(selector) == 0) continue;
+            std::scoped_lock li(index_mtx_);
+            index_.remove(selector);
+            retired++;
+        }
+    }
+    {
+        std::scoped_lock lk(vec_mtx_);
+        for (const std::string& selector : selectors) {
+            if (vec_series_.erase(selector) == 0) continue;
+            std::scoped_lock li(index_mtx_);
+            index_.remove(selector);
+            retired++;
+        }
+    }
+    return retired;
+}
+
+MatrixShape MemoryStore::matrix_shape(const std::string& metric) const {
+    std::scoped_lock lk(vec_mtx_);
+    auto it = vec_series_.find(metric);
+    return it == vec_series_.end() ? MatrixShape{} : it->second->shape;
+}
 
 /**
  * Return samples in the inclusive time range [from_ms, to_ms] for 'metric'.
@@ -100,7 +284,7 @@ void MemoryStore::append_vector(const std::string& metric, int64_t ts_ms, std::v
  */
 std::vector<Sample> MemoryStore::query(const std::string &metric, std::int64_t from_ms, std::int64_t to_ms) const {
     // Find Series without holding the Series lock yet.
-    const Series* s = find_series_(metric);
+    const std::shared_ptr<const Series> s = find_series_(metric);
     if (!s) return {};
 
     // Lock the Series to read a consistent snapshot from the ring.
@@ -108,14 +292,157 @@ std::vector<Sample> MemoryStore::query(const std::string &metric, std::int64_t f
     return s->ring.range(from_ms, to_ms);
 }
 
+std::vector<Sample> MemoryStore::query_downsampled(const std::string &metric, std::int64_t from_ms,
+                                                   std::int64_t to_ms, const DownsampleSpec &spec,
+                                                   DownsampleInfo *info) const {
+    const std::shared_ptr<const Series> s = find_series_(metric);
+    if (!s) return {};
+
+    std::vector<Sample> out;
+    std::scoped_lock ls(s->mtx);
+    const DownsampleInfo done = downsample(s->ring.spans(from_ms, to_ms), spec, out);
+    if (info) *info = done;
+    return out;
+}
+
+std::vector<SampleVec> MemoryStore::query_vector_downsampled(const std::string &metric, std::int64_t from_ms,
+                                                             std::int64_t to_ms, const DownsampleSpec &spec,
+                                                             DownsampleInfo *info) const {
+    std::shared_ptr<const VecSeries> vs;
+    {
+        std::scoped_lock lk(vec_mtx_);
+        auto it = vec_series_.find(metric);
+        if (it == vec_series_.end()) return {};
+        vs = it->second;
+    }
+
+    std::vector<SampleVec> out;
+    std::scoped_lock ls(vs->mtx);
+    const DownsampleInfo done = downsample(vs->ring.spans(from_ms, to_ms), spec, out);
+    if (info) *info = done;
+    return out;
+}
+
+std::vector<SeriesResult> MemoryStore::query_batch(const std::vector<SeriesQuery> &queries) const {
+    std::vector<std::shared_ptr<const Series>> scalars(queries.size());
+    std::vector<std::shared_ptr<const VecSeries>> vectors(queries.size());
+    std::vector<SeriesResult> results(queries.size());
+
+    {
+        std::scoped_lock lk(map_mtx_);
+        for (std::size_t i = 0; i < queries.size(); ++i) {
+            auto it = series_.find(queries[i].selector);
+            if (it != series_.end()) scalars[i] = it->second;
+        }
+    }
+    {
+        std::scoped_lock lk(vec_mtx_);
+        for (std::size_t i = 0; i < queries.size(); ++i) {
+            if (scalars[i]) continue;
+            auto it = vec_series_.find(queries[i].selector);
+            if (it == vec_series_.end()) continue;
+            vectors[i] = it->second;
+            results[i].shape = it->second->shape;
+        }
+    }
+
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+        const SeriesQuery& q = queries[i];
+        const bool reduce = q.downsample.agg != DownsampleAgg::kNone;
+        if (scalars[i]) {
+            std::scoped_lock ls(scalars[i]->mtx);
+            if (reduce) {
+                results[i].downsample = downsample(scalars[i]->ring.spans(q.from_ms, q.to_ms), q.downsample,
+                                                   results[i].samples);
+            } else {
+                results[i].samples = scalars[i]->ring.range(q.from_ms, q.to_ms);
+            }
+        } else if (vectors[i]) {
+            std::scoped_lock ls(vectors[i]->mtx);
+            results[i].is_vector = true;
+            if (reduce) {
+                results[i].downsample = downsample(vectors[i]->ring.spans(q.from_ms, q.to_ms), q.downsample,
+                                                   results[i].vec_samples);
+            } else {
+                results[i].vec_samples = vectors[i]->ring.range(q.from_ms, q.to_ms);
+            }
+        }
+    }
+    return results;
+}
+
+std::vector<LatestSample> MemoryStore::latest_samples() const {
+    struct VecRef {
+        std::string key;
+        std::shared_ptr<const VecSeries> series;
+        MatrixShape shape;
+    };
+    std::vector<std::pair<std::string, std::shared_ptr<const Series>>> scalars;
+    std::vector<VecRef> vectors;
+
+    // Series retired after this point stay alive through the copied pointers
+    {
+        std::scoped_lock lk(map_mtx_);
+        scalars.reserve(series_.size());
+        for (const auto& [key, series] : series_) scalars.emplace_back(key, series);
+    }
+    {
+        std::scoped_lock lk(vec_mtx_);
+        vectors.reserve(vec_series_.size());
+        for (const auto& [key, series] : vec_series_) vectors.push_back(VecRef{key, series, series->shape});
+    }
+
+    std::vector<LatestSample> out;
+    out.reserve(scalars.size() + vectors.size());
+    for (auto& [key, series] : scalars) {
+        std::scoped_lock ls(series->mtx);
+        if (const Sample* newest = series->ring.newest()) {
+            const Sample* before = series->ring.second_newest();
+            out.push_back(LatestSample{std::move(key), false, newest->ts_ms,
+                                       before ? newest->ts_ms - before->ts_ms : 0, {newest->value}, {}});
+        }
+    }
+    for (VecRef& ref : vectors) {
+        std::scoped_lock ls(ref.series->mtx);
+        if (const SampleVec* newest = ref.series->ring.newest()) {
+            const SampleVec* before = ref.series->ring.second_newest();
+            out.push_back(LatestSample{std::move(ref.key), true, newest->ts_ms,
+                                       before ? newest->ts_ms - before->ts_ms : 0, newest->vals,
+                                       std::move(ref.shape)});
+        }
+    }
+    return out;
+}
+
+std::vector<Sample> MemoryStore::query_since(const std::string &metric, std::int64_t after_ms) const {
+    const std::shared_ptr<const Series> s = find_series_(metric);
+    if (!s) return {};
+
+    std::scoped_lock ls(s->mtx);
+    return s->ring.newer_than(after_ms);
+}
+
+std::vector<SampleVec> MemoryStore::query_vector_since(const std::string& metric, std::int64_t after_ms) const {
+    std::shared_ptr<const VecSeries> vs;
+    {
+        std::scoped_lock lk(vec_mtx_);
+        auto it = vec_series_.find(metric);
+        if (it == vec_series_.end()) return {};
+        vs = it->second;
+    }
+
+    std::scoped_lock lk(vs->mtx);
+    return vs->ring.newer_than(after_ms);
+}
+
 std::vector<SampleVec> MemoryStore::query_vector(const std::string& metric, int64_t from_ms, int64_t to_ms) const {
-    const VecSeries* vs = nullptr;
+    std::shared_ptr<const VecSeries> vs;
 
     {
         std::scoped_lock lk(vec_mtx_);
         auto it = vec_series_.find(metric);
         if (it == vec_series_.end()) return {};
-        vs = &it->second;
+        vs = it->second;
     }
 
     // Read under series lock
@@ -125,6 +452,42 @@ std::vector<SampleVec> MemoryStore::query_vector(const std::string& metric, int6
     return vs->ring.range(from_ms, to_ms);
 }
 
+std::optional<std::int64_t> MemoryStore::first_sample_ms(const std::string &metric, std::int64_t from_ms) const {
+    std::shared_ptr<const VecSeries> vs;
+    {
+        std::scoped_lock lk(vec_mtx_);
+        auto it = vec_series_.find(metric);
+        if (it != vec_series_.end()) vs = it->second;
+    }
+    if (vs) {
+        std::scoped_lock lk(vs->mtx);
+        return vs->ring.first_ts_not_before(from_ms);
+    }
+
+    const std::shared_ptr<const Series> s = find_series_(metric);
+    if (!s) return std::nullopt;
+    std::scoped_lock ls(s->mtx);
+    return s->ring.first_ts_not_before(from_ms);
+}
+
+std::size_t MemoryStore::count_between(const std::string &metric, std::int64_t from_ms, std::int64_t to_ms) const {
+    std::shared_ptr<const VecSeries> vs;
+    {
+        std::scoped_lock lk(vec_mtx_);
+        auto it = vec_series_.find(metric);
+        if (it != vec_series_.end()) vs = it->second;
+    }
+    if (vs) {
+        std::scoped_lock lk(vs->mtx);
+        return vs->ring.spans(from_ms, to_ms).size();
+    }
+
+    const std::shared_ptr<const Series> s = find_series_(metric);
+    if (!s) return 0;
+    std::scoped_lock ls(s->mtx);
+    return s->ring.spans(from_ms, to_ms).size();
+}
+
 /**
  * Return the number of samples currently retained for 'metric'.
  * If the metric does not exist, returns 0.
@@ -133,40 +496,26 @@ std::vector<SampleVec> MemoryStore::query_vector(const std::string& metric, int6
  * - Brief map lookup, then Series lock to read size().
  */
 std::size_t MemoryStore::count(const std::string &metric) const {
-    const Series* s = find_series_(metric);
+    const std::shared_ptr<const Series> s = find_series_(metric);
     if (!s) return 0;
 
     std::scoped_lock ls(s->mtx);
     return s->ring.size();
 }
 
-/**
- * ensure_series_:
- * - Non-const accessor that returns a reference to the Series for 'metric',
- *   creating it if missing with the configured per-metric capacity.
- * - Used when the caller intends to modify the Series.
- *
- * Thread-safety:
- * - Locks the map while accessing/creating the Series entry.
- */
-MemoryStore::Series &MemoryStore::ensure_series_(const std::string &metric) {
-    std::scoped_lock lk(map_mtx_);
-    auto [it, _] = series_.try_emplace(metric, per_metric_capacity_);
-    return it->second;
-}
-
 /**
  * find_series_ (const):
- * - Const lookup helper. Returns a pointer to the Series for 'metric' or nullptr if not found.
+ * - Const lookup helper. Returns the Series for 'metric' or nullptr if not found; the
+ *   pointer keeps it alive if it is retired while the caller still reads it.
  * - Does not lock the Series; callers decide if/when to lock the Series for read/write.
  *
  * Thread-safety:
  * - Locks the map while searching.
  */
-const MemoryStore::Series *MemoryStore::find_series_(const std::string &metric) const {
+std::shared_ptr<const MemoryStore::Series> MemoryStore::find_series_(const std::string &metric) const {
     std::scoped_lock lk(map_mtx_);
     auto it = series_.find(metric);
-    return (it == series_.end()) ? nullptr : &it->second;
+    return (it == series_.end()) ? nullptr : it->second;
 }
 
 //std::vector<std::string> MemoryStore::list_series_keys() const {
@@ -198,6 +547,18 @@ std::vector<std::string> MemoryStore::list_series_keys() const {
     return keys;
 }
 
+std::uint64_t MemoryStore::put_table(const std::string &key, nlohmann::json rows, const std::string &id_field) {
+    std::scoped_lock lk(table_mtx_);
+    auto it = tables_.try_emplace(key, id_field).first;
+    return it->second.publish(std::move(rows));
+}
+
+TableRead MemoryStore::read_table(const std::string &key, std::uint64_t since) const {
+    std::scoped_lock lk(table_mtx_);
+    auto it = tables_.find(key);
+    return it == tables_.end() ? TableRead{} : it->second.read(since);
+}
+
 void MemoryStore::put_metadata(const std::string &key, const nlohmann::json &value) {
     std::scoped_lock lk(meta_mtx_);
     metadata_[key] = value;
@@ -218,4 +579,60 @@ nlohmann::json MemoryStore::get_metadata(const std::string &key) const {
     return {};
 }
 
+void MemoryStore::put_incident(std::shared_ptr<const Incident> incident, std::size_t max_incidents) {
+    std::scoped_lock lk(incident_mtx_);
+    incidents_.push_back(std::move(incident));
+    while (incidents_.size() > max_incidents && !incidents_.empty()) incidents_.pop_front();
+}
+
+std::vector<std::shared_ptr<const Incident>> MemoryStore::incidents() const {
+    std::scoped_lock lk(incident_mtx_);
+    return {incidents_.begin(), incidents_.end()};
+}
+
+void MemoryStore::commit(bool new_samples) {
+    {
+        std::scoped_lock lk(commit_mtx_);
+        ++commit_generation_;
+        last_commit_ms_ = now_ms();
 
+        const std::int64_t period = last_commit_ms_ / tick_period_ms_;
+        if (new_samples && period != tick_period_index_) {
+            tick_period_index_ = period;
+            ++tick_generation_;
+        }
+    }
+    commit_cv_.notify_all();
+}
+
+std::uint64_t MemoryStore::commit_generation() const {
+    std::scoped_lock lk(commit_mtx_);
+    return commit_generation_;
+}
+
+void MemoryStore::set_tick_period_ms(std::int64_t period_ms) {
+    std::scoped_lock lk(commit_mtx_);
+    tick_period_ms_ = std::max<std::int64_t>(1, period_ms);
+}
+
+std::uint64_t MemoryStore::tick_generation() const {
+    std::scoped_lock lk(commit_mtx_);
+    return tick_generation_;
+}
+
+std::int64_t MemoryStore::last_commit_ms() const {
+    std::scoped_lock lk(commit_mtx_);
+    return last_commit_ms_;
+}
+
+std::uint64_t MemoryStore::wait_for_commit(std::uint64_t seen, std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lk(commit_mtx_);
+    commit_cv_.wait_for(lk, timeout, [&] { return commit_generation_ != seen; });
+    return commit_generation_;
+}
+
+std::uint64_t MemoryStore::wait_for_tick(std::uint64_t seen, std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lk(commit_mtx_);
+    commit_cv_.wait_for(lk, timeout, [&] { return tick_generation_ != seen; });
+    return tick_generation_;
+}
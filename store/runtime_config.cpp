@@ -0,0 +1,203 @@
+//
+// runtime_config.cpp — JSON config file loading for RuntimeConfig.
+//
+#include "store/runtime_config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <csignal>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+#include "collector/governor.h"
+#include "config.h"
+#include "third_party/json.hpp"
+
+namespace {
+
+using json = nlohmann::json;
+
+constexpr char kDefaultConfigPath[] = "dashboard.json";
+
+// Collector task producing each metric family (name up to the first '.') or,
+// for entries with a '.', each metric; retention seconds are converted to
+// samples with that task's period. The governor's self.* series come once per
+// governor window. The other self.* series are written after every run of the
+// task in their "task" label and are sized per task (see apply_retention);
+// anything else is sampled every SAMPLE_PERIOD_S.
+struct Producer {
+    const char* name;
+    const char* task;
+};
+
+constexpr Producer kProducers[] = {
+        {"cpu.freq_mhz", "sensors"},
+        {"cpu", "cpu"}, {"sched", "cpu"},
+        {"sensor", "sensors"},
+        {"mem", "memory"}, {"vmstat", "memory"}, {"psi", "memory"},
+        {"disk", "disk"},
+        {"net", "network"},
+        {"irq", "irq"}, {"softirq", "irq"},
+        {"cgroup", "cgroup"},
+        {"fs", "filesystem"},
+        {"self.cpu_pct", "governor"}, {"self.degradation_level", "governor"},
+};
+
+constexpr char kGovernor[] = "governor";
+
+// Built-in / env defaults; every load starts from these so removed keys revert
+RuntimeConfig default_config() {
+    RuntimeConfig config;
+    config.retention_s = std::size_t(cfg::KEEP_SECONDS);
+    config.cgroup_max_depth = cfg::CGROUP_MAX_DEPTH;
+    config.cgroup_max_series = cfg::CGROUP_MAX_SERIES;
+    return config;
+}
+
+std::mutex g_config_mtx;
+std::shared_ptr<const RuntimeConfig> g_config = std::make_shared<const RuntimeConfig>(default_config());
+
+volatile std::sig_atomic_t g_reload_requested = 0;
+
+std::string config_path() {
+    const char* env = std::getenv("CONFIG_FILE");
+    return env && *env ? env : kDefaultConfigPath;
+}
+
+int64_t positive(const json& value, const std::string& key) {
+    const int64_t v = value.get<int64_t>();
+    if (v <= 0) throw std::runtime_error("'" + key + "' must be positive");
+    return v;
+}
+
+// Positive integer at j[key], or 'fallback'. Throws on a wrong type.
+int64_t positive_or(const json& j, const char* key, int64_t fallback) {
+    return j.contains(key) ? positive(j.at(key), key) : fallback;
+}
+
+RuntimeConfig parse_config(const json& doc, RuntimeConfig config) {
+    if (!doc.is_object()) throw std::runtime_error("top level must be an object");
+
+    if (doc.contains("periods_ms")) {
+        config.periods_ms.clear();
+        for (const auto& [task, value] : doc.at("periods_ms").items()) {
+            config.periods_ms[task] = positive(value, task);
+        }
+    }
+
+    if (doc.contains("retention_s")) {
+        config.metric_retention_s.clear();
+        for (const auto& [metric, value] : doc.at("retention_s").items()) {
+            const auto seconds = std::size_t(positive(value, metric));
+            if (metric == "default") config.retention_s = seconds;
+            else config.metric_retention_s[metric] = seconds;
+        }
+    }
+
+    if (doc.contains("limits")) {
+        const json& limits = doc.at("limits");
+        config.process_table_limit = std::size_t(positive_or(limits, "process_table", int64_t(config.process_table_limit)));
+        config.cgroup_max_depth = int(positive_or(limits, "cgroup_max_depth", config.cgroup_max_depth));
+        config.cgroup_max_series = int(positive_or(limits, "cgroup_max_series", config.cgroup_max_series));
+    }
+
+    if (doc.contains("disk") && doc.at("disk").contains("aggregate_partitions")) {
+        config.disk_aggregate_partitions = doc.at("disk").at("aggregate_partitions").get<bool>();
+    }
+    return config;
+}
+
+// Period of 'task' as configured (the governor's temporary slow-downs are
+// ignored; they only lengthen the time a ring covers).
+int64_t task_period_ms(const RuntimeConfig& config, const std::string& task) {
+    if (task == kGovernor) return GovernorConfig().window_ms;
+    const int64_t fallback_s = task == "filesystem" ? cfg::FS_PERIOD_S : cfg::SAMPLE_PERIOD_S;
+    return config.period_ms(task, fallback_s * 1000);
+}
+
+// Period of the task behind 'metric'
+int64_t producer_period_ms(const RuntimeConfig& config, const std::string& metric) {
+    const std::string family = metric.substr(0, metric.find('.'));
+    for (const Producer& producer : kProducers) {
+        if (metric != producer.name && family != producer.name) continue;
+        return task_period_ms(config, producer.task);
+    }
+    return int64_t(cfg::SAMPLE_PERIOD_S) * 1000;
+}
+
+std::size_t samples_for(std::size_t seconds, int64_t period_ms) {
+    return std::size_t(int64_t(seconds) * 1000 / std::max<int64_t>(1, period_ms));
+}
+
+} // namespace
+
+int64_t RuntimeConfig::period_ms(const std::string& task, int64_t fallback_ms) const {
+    auto it = periods_ms.find(task);
+    return it == periods_ms.end() ? fallback_ms : it->second;
+}
+
+std::shared_ptr<const RuntimeConfig> runtime_config() {
+    std::scoped_lock lk(g_config_mtx);
+    return g_config;
+}
+
+bool load_runtime_config(std::string& error) {
+    const std::string path = config_path();
+
+    RuntimeConfig config = default_config();
+
+    std::ifstream f(path);
+    if (f.is_open()) {
+        try {
+            config = parse_config(json::parse(f), std::move(config));
+            config.path = path;
+        } catch (const std::exception& e) {
+            error = path + ": " + e.what();
+            return false;
+        }
+    }
+
+    std::scoped_lock lk(g_config_mtx);
+    g_config = std::make_shared<const RuntimeConfig>(std::move(config));
+    return true;
+}
+
+void request_config_reload() {
+    g_reload_requested = 1;
+}
+
+bool take_config_reload_request() {
+    if (!g_reload_requested) return false;
+    g_reload_requested = 0;
+    return true;
+}
+
+void apply_retention(MemoryStore& store, const RuntimeConfig& config) {
+    std::unordered_map<std::string, std::size_t> per_metric;
+    std::unordered_map<std::string, std::size_t> per_family;
+    for (const Producer& producer : kProducers) {
+        const std::string name = producer.name;
+        const std::size_t samples = samples_for(config.retention_s, producer_period_ms(config, name));
+        if (name.find('.') != std::string::npos) per_metric[name] = samples;
+        else per_family[name] = samples;
+    }
+    for (const auto& [metric, seconds] : config.metric_retention_s) {
+        per_metric[metric] = samples_for(seconds, producer_period_ms(config, metric));
+    }
+
+    // Per-task self.* series: every task whose period may differ from the default
+    LabelRetention self_by_task{"self", "task", {}};
+    for (const Producer& producer : kProducers) {
+        if (producer.task == std::string(kGovernor)) continue;
+        self_by_task.by_value[producer.task] = samples_for(config.retention_s, task_period_ms(config, producer.task));
+    }
+    for (const auto& [task, period_ms] : config.periods_ms) {
+        self_by_task.by_value[task] = samples_for(config.retention_s, period_ms);
+    }
+
+    const int64_t default_period_ms = int64_t(cfg::SAMPLE_PERIOD_S) * 1000;
+    store.set_retention(samples_for(config.retention_s, default_period_ms), std::move(per_metric),
+                        std::move(per_family), std::move(self_by_task));
+}
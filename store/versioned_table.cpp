@@ -0,0 +1,103 @@
+//
+// versioned_table.cpp — generations and per-field diffs for row tables.
+//
+// Rows are matched by id field; a changed row lists only the fields whose
+// value differs. The delta from the previous generation is computed once at
+// publish time, since nearly every poller is exactly one generation behind.
+//
+#include "store/versioned_table.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "metrics/time.h"
+
+namespace {
+using json = nlohmann::json;
+
+std::unordered_map<std::string, const json*> index_rows(const json& rows, const std::string& id_field) {
+    std::unordered_map<std::string, const json*> index;
+    index.reserve(rows.size());
+    for (const json& row : rows) {
+        const auto id = row.find(id_field);
+        if (id != row.end()) index.emplace(id->dump(), &row);
+    }
+    return index;
+}
+} // namespace
+
+VersionedTable::VersionedTable(std::string id_field)
+        : id_field_(std::move(id_field)), generation_(static_cast<std::uint64_t>(now_ms())) {}
+
+std::uint64_t VersionedTable::publish(json rows) {
+    if (!history_.empty() && history_.back().second == rows) return generation_;
+
+    ++generation_;
+    if (!history_.empty()) {
+        last_delta_ = diff(history_.back().second, rows);
+        last_delta_.generation = generation_;
+    }
+    history_.emplace_back(generation_, std::move(rows));
+    while (history_.size() > kTableHistory) history_.pop_front();
+    return generation_;
+}
+
+TableRead VersionedTable::read(std::uint64_t since) const {
+    TableRead out;
+    out.generation = generation_;
+    if (history_.empty()) return out;
+
+    if (since == generation_) {
+        out.is_delta = true;
+        return out;
+    }
+    if (since + 1 == generation_ && last_delta_.generation == generation_) return last_delta_;
+
+    for (const auto& [generation, rows] : history_) {
+        if (generation != since) continue;
+        out = diff(rows, history_.back().second);
+        out.generation = generation_;
+        return out;
+    }
+
+    out.rows = history_.back().second;
+    return out;
+}
+
+TableRead VersionedTable::diff(const json& before, const json& after) const {
+    TableRead out;
+    out.is_delta = true;
+
+    const auto old_rows = index_rows(before, id_field_);
+    std::unordered_set<std::string> seen;
+    seen.reserve(after.size());
+
+    for (const json& row : after) {
+        const auto id = row.find(id_field_);
+        if (id == row.end()) continue;
+        const std::string key = id->dump();
+        seen.insert(key);
+
+        const auto old_it = old_rows.find(key);
+        if (old_it == old_rows.end()) {
+            out.added.push_back(row);
+            continue;
+        }
+
+        const json& old_row = *old_it->second;
+        json fields = json::object();
+        for (const auto& [field, value] : row.items()) {
+            const auto old_value = old_row.find(field);
+            if (old_value == old_row.end() || *old_value != value) fields[field] = value;
+        }
+        if (!fields.empty()) {
+            fields[id_field_] = *id;
+            out.changed.push_back(std::move(fields));
+        }
+    }
+
+    for (const auto& [key, row] : old_rows) {
+        if (!seen.count(key)) out.removed.push_back(row->at(id_field_));
+    }
+    return out;
+}
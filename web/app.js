@@ -1,16 +1,22 @@
 // web/app.js — orchestrates dashboard charts, process table, and interactions.
 //
-// Polling overview:
+// Data flow overview:
 // - Each chart is registered with a ChartRegistry which keeps an in-memory buffer of
 //   timestamps + values and the last timestamp received from the backend.
-// - A lightweight ticker (makePoller) invokes the registry refresh for the active tab
-//   every ~1s. Hidden tabs keep their state but the poller is paused, so they do not
-//   hit /api/query until re-activated.
-// - Every refresh only asks the backend for new samples (`from = lastTs + 1`), then
-//   appends them to the buffer and trims anything older than the selected time window
-//   (sliding window, default 10 minutes).
-// - The process table has its own ticker so that chart polling and /api/processes do
-//   not contend with each other.
+// - The active tab's registry holds one /api/stream (Server-Sent Events) connection
+//   for all of its charts: the server first replays the selected time window
+//   (downsampled to roughly the chart width), then pushes each tick's new samples
+//   as the sampler commits them. Hidden tabs keep
+//   their state but close their stream until re-activated.
+// - New samples are appended to the buffer, which is trimmed to the selected time
+//   window (sliding window, default 2 hours). Samples at or before lastTs are
+//   dropped, so replays after a reconnect are harmless.
+// - Without EventSource support, a lightweight ticker (makePoller) falls back to
+//   asking /api/query_batch for every chart's new samples (`from = lastTs + 1`) in
+//   one request every ~1s.
+// - The process table has its own ticker so that chart updates and /api/processes do
+//   not contend with each other. It asks for the rows changed since the generation
+//   it holds (`?since=`), and gets 304 when nothing changed.
 
 
 // Constants & State
@@ -32,6 +38,8 @@ function resolveApiBase() {
 const API_BASE_URL = resolveApiBase();
 const PROCESS_REFRESH_MS = 1000;
 const CHART_REFRESH_MS = 1000;
+const STREAM_RETRY_MS = 2000;
+const USE_STREAM = typeof window.EventSource === "function";
 const DEFAULT_TIME_WINDOW_S = 7200;
 const MAX_POINTS_PAD = 30; // additional guardrail beyond expected samples
 
@@ -40,7 +48,10 @@ window.TIME_WINDOW_S = DEFAULT_TIME_WINDOW_S;
 let cpuTotalChart;
 let perCoreChart;
 let TOTAL_MEM_BYTES = 0;
+let METRIC_UNITS = new Map();
 let ACTIVE_TAB = "cpu";
+// Rows by pid and the server generation they reflect (see /api/processes?since=)
+const PROCESS_TABLE = {generation: 0, rows: new Map()};
 
 const MEMORY_DASHBOARD = {
     metrics: [],
@@ -119,8 +130,8 @@ async function fetchSystemInfo() {
     return response.json();
 }
 
-async function fetchStoredMetrics() {
-    const url = `${API_BASE_URL}/api/stored`;
+async function fetchStoredMetrics(prefix = "") {
+    const url = `${API_BASE_URL}/api/stored?prefix=${encodeURIComponent(prefix)}`;
     try {
         const response = await fetch(url);
         if (!response.ok) throw new Error(`HTTP ${response.status}`);
@@ -130,31 +141,66 @@ async function fetchStoredMetrics() {
     }
 }
 
-async function fetchTimeseriesData({metric, labels = null, from = 0, to = Date.now()}) {
-    const query = new URLSearchParams({metric, from: String(from), to: String(to)});
+async function fetchTimeseriesBatch(queries) {
+    const response = await fetch(`${API_BASE_URL}/api/query_batch`, {
+        method: "POST",
+        headers: {"Content-Type": "application/json"},
+        body: JSON.stringify({queries})
+    });
+    if (!response.ok) throw new Error(`HTTP ${response.status}`);
+    const payload = await response.json();
+    return Array.isArray(payload?.results) ? payload.results : [];
+}
 
-    if (labels && typeof labels === "object") {
-        const labelPairs = Object.entries(labels)
-            .map(([key, value]) => `${key}:${encodeURIComponent(String(value))}`)
-            .join(",");
-        if (labelPairs) query.set("labels", labelPairs);
+async function fetchMetricUnits() {
+    try {
+        const response = await fetch(`${API_BASE_URL}/api/metrics`);
+        if (!response.ok) throw new Error(`HTTP ${response.status}`);
+        const registry = await response.json();
+        return new Map((registry.metrics || []).map(metric => [metric.name, metric.unit]));
+    } catch (error) {
+        console.error("Failed to load metric registry:", error);
+        return new Map();
     }
-
-    const response = await fetch(`${API_BASE_URL}/api/query?${query.toString()}`);
-    if (!response.ok) throw new Error(`HTTP ${response.status}`);
-    return response.json();
 }
 
-async function fetchProcessesSnapshot() {
-    const response = await fetch(`${API_BASE_URL}/api/processes`);
+/**
+ * Bring PROCESS_TABLE up to date with one /api/processes?since= request.
+ * Returns false when nothing changed (304).
+ */
+async function fetchProcessesDelta() {
+    const response = await fetch(`${API_BASE_URL}/api/processes?since=${PROCESS_TABLE.generation}`);
+    if (response.status === 304) return false;
     if (!response.ok) throw new Error("Failed to load processes");
-    return response.json();
+
+    const update = await response.json();
+    if (Array.isArray(update.rows)) {
+        PROCESS_TABLE.rows = new Map(update.rows.map(row => [row.pid, row]));
+    } else {
+        (update.removed || []).forEach(pid => PROCESS_TABLE.rows.delete(pid));
+        (update.added || []).forEach(row => PROCESS_TABLE.rows.set(row.pid, row));
+        (update.changed || []).forEach(fields => {
+            const row = PROCESS_TABLE.rows.get(fields.pid);
+            if (row) Object.assign(row, fields);
+        });
+    }
+    PROCESS_TABLE.generation = update.generation || 0;
+    return true;
 }
 
 // Data Processing
 async function initializeSystemMetadata() {
     const metadata = await fetchSystemInfo();
     TOTAL_MEM_BYTES = metadata.mem_total_bytes || 0;
+    METRIC_UNITS = await fetchMetricUnits();
+}
+
+/**
+ * Stream selector for a chart: `metric{key=value,...}` (the server adds host).
+ */
+function selectorFor(metric, labels) {
+    const pairs = Object.entries(labels || {}).map(([key, value]) => `${key}=${value}`);
+    return pairs.length ? `${metric}{${pairs.join(",")}}` : metric;
 }
 
 /**
@@ -312,23 +358,36 @@ function getMaxPoints() {
     return Math.max(60, Math.ceil(getWindowMs() / CHART_REFRESH_MS) + MAX_POINTS_PAD);
 }
 
+// History is fetched downsampled to about one point per horizontal pixel of
+// the widest chart (0 when no chart is laid out yet: ask for raw samples).
+function historyPointBudget(entries) {
+    return Math.max(0, ...entries.map(entry => Math.round(entry.chart?.getWidth?.() || 0)));
+}
+
 /**
- * Keeps track of metrics, their buffers, and incremental refresh.
+ * Keeps track of metrics, their buffers, and incremental refresh (streamed, or
+ * polled when EventSource is unavailable).
  */
 class ChartRegistry {
     constructor() {
         this.entries = [];
+        this.source = null;
+        this.retryTimer = null;
+        this.bySelector = new Map();
     }
 
-    registerChart({chart, metric, labels = null, title = metric}) {
-        chart.setOption(makeBaseOption(title));
+    // 'ingest' replaces the default single-line buffer for charts that keep
+    // their own state (e.g. the per-core chart).
+    registerChart({chart, metric, labels = null, title = metric, ingest = null}) {
+        if (!ingest) chart.setOption(makeBaseOption(title));
         const entry = {
             chart,
             metric,
             labels,
             title,
+            ingest,
             lastTs: 0,
-            unit: "",
+            unit: METRIC_UNITS.get(metric) || "",
             buffer: {timestamps: [], values: []}
         };
         this.entries.push(entry);
@@ -343,30 +402,23 @@ class ChartRegistry {
         });
     }
 
-    async refreshEntry(entry) {
-        if (!entry.chart) return;
-
-        const now = Date.now();
-        const windowMs = getWindowMs();
-        const from = entry.lastTs ? entry.lastTs + 1 : Math.max(0, now - windowMs);
-        let info;
-        try {
-            info = await fetchTimeseriesData({metric: entry.metric, labels: entry.labels, from, to: now});
-        } catch (error) {
-            console.error(`Failed to refresh ${entry.metric}`, error);
+    /**
+     * Append samples newer than entry.lastTs, trim to the window, and render.
+     */
+    ingestSamples(entry, samples) {
+        const fresh = samples.filter(([ts]) => ts > entry.lastTs);
+        if (fresh.length) entry.lastTs = fresh[fresh.length - 1][0];
+        if (entry.ingest) {
+            entry.ingest(fresh);
             return;
         }
 
-        const samples = Array.isArray(info?.samples) ? info.samples : [];
-        if (samples.length) {
-            entry.lastTs = samples[samples.length - 1][0];
-            for (const [ts, value] of samples) {
-                entry.buffer.timestamps.push(ts);
-                entry.buffer.values.push(value);
-            }
+        for (const [ts, value] of fresh) {
+            entry.buffer.timestamps.push(ts);
+            entry.buffer.values.push(value);
         }
 
-        const windowStart = now - windowMs;
+        const windowStart = Date.now() - getWindowMs();
         while (entry.buffer.timestamps.length && entry.buffer.timestamps[0] < windowStart) {
             entry.buffer.timestamps.shift();
             entry.buffer.values.shift();
@@ -379,18 +431,93 @@ class ChartRegistry {
         }
 
         const labels = entry.buffer.timestamps.map(ts => new Date(ts).toLocaleTimeString());
-        if (info?.unit) entry.unit = info.unit;
         const payload = {
             labels,
             data: entry.buffer.values.slice(),
             unit: entry.unit,
-            datasetLabel: entry.title || info?.metric || entry.metric
+            datasetLabel: entry.title || entry.metric
         };
         renderTimeseriesChart(entry.chart, payload);
     }
 
+    /**
+     * Poll every chart's new samples with one /api/query_batch request.
+     */
     async refreshAll() {
-        await Promise.all(this.entries.map(entry => this.refreshEntry(entry)));
+        const active = this.entries.filter(entry => entry.chart);
+        if (!active.length) return;
+
+        const now = Date.now();
+        const windowStart = Math.max(0, now - getWindowMs());
+        const budget = historyPointBudget(active);
+        let results;
+        try {
+            results = await fetchTimeseriesBatch(active.map(entry => ({
+                metric: entry.metric,
+                labels: entry.labels || {},
+                from: entry.lastTs ? entry.lastTs + 1 : windowStart,
+                to: now,
+                ...(budget ? {max_points: budget} : {})
+            })));
+        } catch (error) {
+            console.error("Failed to refresh charts", error);
+            return;
+        }
+
+        results.forEach((info, index) => {
+            const entry = active[index];
+            if (!entry || info?.error) {
+                if (info?.error) console.error(`Failed to refresh ${entry?.metric}`, info.error);
+                return;
+            }
+            if (info.unit) entry.unit = info.unit;
+            this.ingestSamples(entry, Array.isArray(info.samples) ? info.samples : []);
+        });
+    }
+
+    /**
+     * Open one /api/stream connection for every registered chart. The replay
+     * starts at the oldest point any chart still needs.
+     */
+    startStream() {
+        this.stopStream();
+        if (!this.entries.length) return;
+
+        const windowStart = Math.max(0, Date.now() - getWindowMs());
+        const from = Math.min(...this.entries.map(entry => entry.lastTs ? entry.lastTs + 1 : windowStart));
+        const query = new URLSearchParams({from: String(from)});
+        const budget = historyPointBudget(this.entries);
+        if (budget) query.set("max_points", String(budget));
+        this.entries.forEach(entry => query.append("series", selectorFor(entry.metric, entry.labels)));
+
+        const source = new EventSource(`${API_BASE_URL}/api/stream?${query.toString()}`);
+        source.addEventListener("subscribed", event => {
+            // Canonical selectors, in the order the charts were listed
+            const selectors = JSON.parse(event.data).series || [];
+            this.bySelector = new Map(selectors.map((selector, index) => [selector, this.entries[index]]));
+        });
+        source.addEventListener("samples", event => {
+            const message = JSON.parse(event.data);
+            const entry = this.bySelector.get(message.series);
+            if (entry) this.ingestSamples(entry, message.samples || []);
+        });
+        source.onerror = () => {
+            // Reconnect ourselves so the replay resumes from each chart's lastTs
+            this.stopStream();
+            this.retryTimer = setTimeout(() => this.startStream(), STREAM_RETRY_MS);
+        };
+        this.source = source;
+    }
+
+    stopStream() {
+        if (this.retryTimer) {
+            clearTimeout(this.retryTimer);
+            this.retryTimer = null;
+        }
+        if (this.source) {
+            this.source.close();
+            this.source = null;
+        }
     }
 }
 
@@ -435,6 +562,7 @@ function initPerCoreChart() {
     });
 
     window.addEventListener("resize", () => perCoreChart && perCoreChart.resize());
+    CPU_REGISTRY.registerChart({chart: perCoreChart, metric: "cpu.core_pct", ingest: ingestCoreSamples});
 }
 
 function renderPerCoreChart(labels, coreSeries) {
@@ -454,34 +582,17 @@ function renderPerCoreChart(labels, coreSeries) {
 }
 
 const CORE_STATE = {
-    samples: [],
-    lastTs: 0
+    samples: []
 };
 
 function resetCoreState() {
     CORE_STATE.samples = [];
-    CORE_STATE.lastTs = 0;
 }
 
-async function refreshPerCoreData() {
-    const now = Date.now();
-    const windowMs = getWindowMs();
-    const from = CORE_STATE.lastTs ? CORE_STATE.lastTs + 1 : Math.max(0, now - windowMs);
-    let info;
-    try {
-        info = await fetchTimeseriesData({metric: "cpu.core_pct", from, to: now});
-    } catch (error) {
-        console.error("Failed to refresh cpu.core_pct", error);
-        return;
-    }
+function ingestCoreSamples(samples) {
+    if (samples.length) CORE_STATE.samples.push(...samples);
 
-    const samples = Array.isArray(info?.samples) ? info.samples : [];
-    if (samples.length) {
-        CORE_STATE.lastTs = samples[samples.length - 1][0];
-        CORE_STATE.samples.push(...samples);
-    }
-
-    const windowStart = now - windowMs;
+    const windowStart = Date.now() - getWindowMs();
     while (CORE_STATE.samples.length && CORE_STATE.samples[0][0] < windowStart) {
         CORE_STATE.samples.shift();
     }
@@ -500,7 +611,7 @@ async function refreshPerCoreData() {
 async function setupDiskCharts() {
     if (DISK_DASHBOARD.ready) return;
 
-    const stored = await fetchStoredMetrics();
+    const stored = await fetchStoredMetrics("disk.");
     if (!stored || !Array.isArray(stored.metrics)) return;
 
     const diskEntries = stored.metrics
@@ -547,7 +658,7 @@ async function setupDiskCharts() {
 async function setupMemoryCharts() {
     if (MEMORY_DASHBOARD.ready) return;
 
-    const stored = await fetchStoredMetrics();
+    const stored = await fetchStoredMetrics("mem");
     if (!stored || !Array.isArray(stored.metrics)) return;
 
     MEMORY_DASHBOARD.metrics = stored.metrics
@@ -578,7 +689,7 @@ async function setupMemoryCharts() {
 async function setupNetworkCharts() {
     if (NETWORK_DASHBOARD.ready) return;
 
-    const stored = await fetchStoredMetrics();
+    const stored = await fetchStoredMetrics("net.");
     if (!stored || !Array.isArray(stored.metrics)) return;
 
     const netEntries = stored.metrics
@@ -648,7 +759,10 @@ function renderProcessTable(rows) {
 
 async function loadProcesses() {
     try {
-        const rows = await fetchProcessesSnapshot();
+        if (!await fetchProcessesDelta()) return;
+        // Deltas carry no order; the server ranks by CPU, so do the same
+        const rows = Array.from(PROCESS_TABLE.rows.values())
+            .sort((a, b) => (b.cpu_pct || 0) - (a.cpu_pct || 0) || a.pid - b.pid);
         renderProcessTable(rows);
     } catch (_) {
         document.querySelector("#proc-table tbody").innerHTML =
@@ -713,26 +827,25 @@ function activatePanel(panelId, tabBtn) {
                     "net";
 }
 
-function refreshActiveTabNow() {
-    if (ACTIVE_TAB === "cpu") {
-        CPU_REGISTRY.refreshAll();
-        refreshPerCoreData();
-    } else if (ACTIVE_TAB === "mem") {
-        MEM_REGISTRY.refreshAll();
-    } else if (ACTIVE_TAB === "disk") {
-        DISK_REGISTRY.refreshAll();
-    } else if (ACTIVE_TAB === "net") {
-        NET_REGISTRY.refreshAll();
-    }
-}
+const TAB_REGISTRIES = {
+    cpu: CPU_REGISTRY,
+    mem: MEM_REGISTRY,
+    disk: DISK_REGISTRY,
+    net: NET_REGISTRY
+};
 
-function stopAllTabPollers() {
+function stopAllTabUpdates() {
+    Object.values(TAB_REGISTRIES).forEach(registry => registry.stopStream());
     Object.values(TAB_POLLERS).forEach(poller => poller.stop());
 }
 
-function syncActiveTabPolling() {
-    stopAllTabPollers();
-    TAB_POLLERS[ACTIVE_TAB]?.start();
+function syncActiveTabUpdates() {
+    stopAllTabUpdates();
+    if (USE_STREAM) {
+        TAB_REGISTRIES[ACTIVE_TAB]?.startStream();
+    } else {
+        TAB_POLLERS[ACTIVE_TAB]?.start();
+    }
 }
 
 function wireTabs() {
@@ -743,31 +856,28 @@ function wireTabs() {
 
     cpuBtn?.addEventListener("click", () => {
         activatePanel("panel-cpu", cpuBtn);
-        syncActiveTabPolling();
+        syncActiveTabUpdates();
     });
 
     memBtn?.addEventListener("click", async () => {
         activatePanel("panel-mem", memBtn);
-        stopAllTabPollers();
+        stopAllTabUpdates();
         await setupMemoryCharts();
-        await MEM_REGISTRY.refreshAll();
-        syncActiveTabPolling();
+        syncActiveTabUpdates();
     });
 
     diskBtn?.addEventListener("click", async () => {
         activatePanel("panel-disk", diskBtn);
-        stopAllTabPollers();
+        stopAllTabUpdates();
         await setupDiskCharts();
-        await DISK_REGISTRY.refreshAll();
-        syncActiveTabPolling();
+        syncActiveTabUpdates();
     });
 
     netBtn?.addEventListener("click", async () => {
         activatePanel("panel-net", netBtn);
-        stopAllTabPollers();
+        stopAllTabUpdates();
         await setupNetworkCharts();
-        await NET_REGISTRY.refreshAll();
-        syncActiveTabPolling();
+        syncActiveTabUpdates();
     });
 }
 
@@ -779,7 +889,7 @@ function selectTimeFrame(seconds) {
     DISK_REGISTRY.resetState();
     NET_REGISTRY.resetState();
     resetCoreState();
-    refreshActiveTabNow();
+    syncActiveTabUpdates();
 }
 
 window.selectTimeFrame = selectTimeFrame;
@@ -827,10 +937,10 @@ function makePoller(task, intervalMs) {
     };
 }
 
+// Fallback when EventSource is unavailable
 const TAB_POLLERS = {
     cpu: makePoller(async () => {
         await CPU_REGISTRY.refreshAll();
-        await refreshPerCoreData();
     }, CHART_REFRESH_MS),
     mem: makePoller(async () => {
         await MEM_REGISTRY.refreshAll();
@@ -854,9 +964,6 @@ document.addEventListener("DOMContentLoaded", async () => {
     wireTabs();
     enableProcessTableColumnResize();
 
-    await CPU_REGISTRY.refreshAll();
-    await refreshPerCoreData();
-
     PROCESS_POLLER.start();
-    syncActiveTabPolling();
+    syncActiveTabUpdates();
 });